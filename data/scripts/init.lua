@@ -281,6 +281,7 @@ function globalPropertyd(name, default)
     local ref = findProp(name, "double")
     return {
         __property = 1;
+        ref = ref;
         get = function() return getPropd(ref, default); end;
         set = function(self, value) setPropd(ref, value); end;
     }
@@ -293,8 +294,11 @@ function createGlobalPropertyd(name, default)
 end
 
 -- create new global functional double property
-function createFuncPropertyd(name, getter, setter)
-    local ref = createFuncProp(name, 'double', getter, setter)
+-- cache is optional caching policy of getter results: "frame" calls
+-- getter once per frame, "set" calls getter on first read after setter,
+-- number of milliseconds keeps value for that time
+function createFuncPropertyd(name, getter, setter, cache)
+    local ref = createFuncProp(name, 'double', getter, setter, 0, cache)
     return globalPropertyd(name)
 end
 
@@ -304,6 +308,7 @@ function globalPropertyf(name, default)
     local ref = findProp(name, "float")
     return {
         __property = 1;
+        ref = ref;
         get = function() return getPropf(ref, default); end;
         set = function(self, value) setPropf(ref, value); end;
     }
@@ -316,8 +321,8 @@ function createGlobalPropertyf(name, default)
 end
 
 -- create new global functional float property
-function createFuncPropertyf(name, getter, setter)
-    local ref = createFuncProp(name, 'float', getter, setter)
+function createFuncPropertyf(name, getter, setter, cache)
+    local ref = createFuncProp(name, 'float', getter, setter, 0, cache)
     return globalPropertyf(name)
 end
 
@@ -327,6 +332,7 @@ function globalPropertyi(name, default)
     local ref = findProp(name, "int")
     return {
         __property = 1;
+        ref = ref;
         get = function(doNotCall) return getPropi(ref, default); end;
         set = function(self, value) setPropi(ref, value); end;
     }
@@ -339,8 +345,8 @@ function createGlobalPropertyi(name, default)
 end
 
 -- create new global functional int property
-function createFuncPropertyi(name, getter, setter)
-    local ref = createFuncProp(name, 'int', getter, setter)
+function createFuncPropertyi(name, getter, setter, cache)
+    local ref = createFuncProp(name, 'int', getter, setter, 0, cache)
     return globalPropertyi(name)
 end
 
@@ -349,6 +355,8 @@ function globalPropertys(name, default)
     local ref = findProp(name, "string")
     return {
         __property = 1;
+        ref = ref;
+        type = "string";
         get = function(doNotCall) return getProps(ref, default); end;
         set = function(self, value) setProps(ref, value); end;
     }
@@ -361,12 +369,101 @@ function createGlobalPropertys(name, maxLen, default)
 end
 
 -- create new global functional string property
-function createFuncPropertys(name, getter, setter, maxSize)
-    local ref = createFuncProp(name, 'string', getter, setter, maxSize)
+function createFuncPropertys(name, getter, setter, maxSize, cache)
+    local ref = createFuncProp(name, 'string', getter, setter, maxSize, cache)
     return globalPropertys(name)
 end
 
 
+-- returns simulator float array property
+-- get returns table of size elements starting from offset.  the same
+-- table is filled by each read
+function globalPropertyfa(name, size, offset)
+    local ref = findProp(name, "float")
+    local values = { }
+    offset = offset or 0
+    return {
+        __property = 1;
+        ref = ref;
+        get = function() getPropArrayf(ref, offset, size, values); return values; end;
+        set = function(self, value) setPropArrayf(ref, offset, value); end;
+    }
+end
+
+-- returns simulator int array property
+-- get returns table of size elements starting from offset.  the same
+-- table is filled by each read
+function globalPropertyia(name, size, offset)
+    local ref = findProp(name, "int")
+    local values = { }
+    offset = offset or 0
+    return {
+        __property = 1;
+        ref = ref;
+        get = function() getPropArrayi(ref, offset, size, values); return values; end;
+        set = function(self, value) setPropArrayi(ref, offset, value); end;
+    }
+end
+
+-- call callback with new value when value of global property changes
+-- by more than epsilon.  callbacks are called once per frame before
+-- update, first time at the next update after subscription.
+-- returns subscription ID to pass to removePropertyListener
+function addPropertyListener(property, callback, epsilon)
+    local ref = rawget(property, "ref")
+    if not ref then
+        logError("can't listen to property without reference")
+        return nil
+    end
+    return subscribeProp(ref, callback, epsilon or 0, 
+            rawget(property, "type"))
+end
+
+-- true while property change callbacks are called
+local notifyingListeners = false
+
+-- IDs of listeners removed while callbacks are called
+local removedListeners = nil
+
+-- stop calling property change callback
+function removePropertyListener(id)
+    unsubscribeProp(id)
+    if notifyingListeners then
+        removedListeners = removedListeners or { }
+        removedListeners[id] = true
+    end
+end
+
+-- called by properties update once per frame.  changes contains count
+-- triples of subscription ID, callback and new value
+function notifyPropertyListeners(changes, count)
+    notifyingListeners = true
+    for i = 1, count * 3, 3 do
+        if not (removedListeners and removedListeners[changes[i]]) then
+            local ok, err = pcall(changes[i + 1], changes[i + 2])
+            if not ok then
+                logError("Error calling property change callback:", err)
+            end
+        end
+    end
+    notifyingListeners = false
+    removedListeners = nil
+end
+
+-- ask remote properties server to send changes of property at most
+-- rate times per second and only if value changed by more than deadband.
+-- if relative is true deadband is fraction of last sent value.
+-- returns false if properties are not networked
+function setPropertyPush(property, rate, deadband, relative)
+    local ref = rawget(property, "ref")
+    if not ref then
+        logError("can't push property without reference")
+        return false
+    end
+    return setPropPush(ref, rate, deadband or 0, relative)
+end
+
+
 -- returns value of property
 -- traverse recursive properties
 function get(property, doNotCall)
@@ -452,15 +549,138 @@ function updateAll(table)
     end
 end
 
+-- spatial indexes of components lists used to find components under mouse.
+-- keys are weak so indexes are collected together with lists
+local hitIndexes = setmetatable({ }, { __mode = "k" })
+
+-- lists shorter than this are checked without index
+local HIT_INDEX_MIN_SIZE = 8
+
+
+-- returns spatial index of components list or nil if list is too short.
+-- index is rebuilt if list or positions of components changed
+local function getHitIndex(list)
+    local count = #list
+    if HIT_INDEX_MIN_SIZE > count then
+        return nil
+    end
+
+    local h = hitIndexes[list]
+    if not h then
+        h = { index = createHitIndex(), components = { }, found = { } }
+        hitIndexes[list] = h
+    end
+
+    if h.valid and (h.count == count) then
+        -- components could be replaced or reordered without changing size
+        local components = h.components
+        for i = 1, count do
+            if list[i] ~= components[i] then
+                h.valid = false
+                break
+            end
+        end
+    end
+
+    if (not h.valid) or (h.count ~= count) then
+        hitIndexClear(h.index)
+        local components = h.components
+        for i = 1, count do
+            local v = list[i]
+            components[i] = v
+            local pos = get(v.position)
+            if pos then
+                hitIndexAdd(h.index, i, pos[1], pos[2], pos[3], pos[4])
+                -- position stored in index
+                local r = rawget(v, "_hitRect") or { }
+                r[1], r[2], r[3], r[4] = pos[1], pos[2], pos[3], pos[4]
+                v._hitRect = r
+            end
+        end
+        for i = #components, count + 1, -1 do
+            components[i] = nil
+        end
+        h.count = count
+        h.valid = true
+    end
+
+    return h
+end
+
+
+-- force spatial index of components list to be rebuilt.
+-- component positions are checked during drawing, use it for
+-- components which are not drawn
+function invalidateHitIndex(list)
+    local h = hitIndexes[list]
+    if h then
+        h.valid = false
+    end
+end
+
+
+-- invalidate spatial index of list if component was moved
+local function checkHitRect(v, pos, list)
+    local h = hitIndexes[list]
+    if h and h.valid then
+        local r = rawget(v, "_hitRect")
+        if (not r) or (r[1] ~= pos[1]) or (r[2] ~= pos[2]) or 
+                (r[3] ~= pos[3]) or (r[4] ~= pos[4]) then
+            h.valid = false
+        end
+    end
+end
+
+
+-- returns iterator over children of component which may contain point.
+-- children are returned starting from topmost one.  caller should check
+-- visibility and position of each child
+function childrenAt(component, x, y)
+    local list = component.components
+    local h = getHitIndex(list)
+
+    if not h then
+        local i = #list + 1
+        return function()
+            i = i - 1
+            return list[i]
+        end
+    end
+
+    -- scratch table is reused by every search in this list.  lists are
+    -- not nested into itself, so iterations of same list don't overlap
+    local found = h.found
+    local count = hitIndexFind(h.index, x, y, found)
+
+    local i = 0
+    return function()
+        i = i + 1
+        if i <= count then
+            return list[found[i]]
+        end
+    end
+end
+
+
 -- draw component
-function drawComponent(v)
+function drawComponent(v, list)
     if v and toboolean(get(v.visible)) then
         saveGraphicsContext()
         local pos = get(v.position)
+        if list then
+            checkHitRect(v, pos, list)
+        end
         setTranslation(pos[1], pos[2], pos[3], pos[4], v.size[1], v.size[2])
 		local clip = get(v.clip)
 
-		v:draw()
+        if not toboolean(get(rawget(v, "cacheRender"))) then
+            if rawget(v, "_renderCache") then
+                releaseRenderCache(v)
+            end
+            v:draw()
+        elseif not drawCachedComponent(v) then
+            v:draw()
+        end
 
         if toboolean(clip) then
             setClipArea(clip[1], clip[2], clip[3], clip[4])
@@ -472,10 +692,177 @@ function drawComponent(v)
 end
 
 
+-- returns true if value of cache input differs from saved one.
+-- tables are compared element by element, nested tables are compared
+-- by reference
+local function renderCacheInputDiffers(saved, value)
+    if "table" ~= type(value) then
+        return saved ~= value
+    end
+    if "table" ~= type(saved) then
+        return true
+    end
+    for k, v in pairs(value) do
+        if saved[k] ~= v then
+            return true
+        end
+    end
+    for k, _ in pairs(saved) do
+        if nil == value[k] then
+            return true
+        end
+    end
+    return false
+end
+
+
+-- returns true if any of component cache inputs changed since last check.
+-- table values are copied because properties may return the same table
+-- with changed contents
+function renderCacheInputsChanged(v, cache)
+    local inputs = get(rawget(v, "cacheInputs"))
+    if not inputs then
+        return false
+    end
+
+    local changed = false
+    for i, p in ipairs(inputs) do
+        local value = get(p)
+        local saved = cache.inputs[i]
+        if renderCacheInputDiffers(saved, value) then
+            if "table" == type(value) then
+                if "table" ~= type(saved) then
+                    saved = { }
+                    cache.inputs[i] = saved
+                end
+                for k, _ in pairs(saved) do
+                    saved[k] = nil
+                end
+                for k, x in pairs(value) do
+                    saved[k] = x
+                end
+            else
+                cache.inputs[i] = value
+            end
+            changed = true
+        end
+    end
+    return changed
+end
+
+
+-- draw component from texture.  component subtree is rendered into
+-- texture only if texture size or any of cacheInputs properties changed.
+-- texture is cacheScale times bigger than component size.
+-- returns false if render targets are not supported
+function drawCachedComponent(v)
+    local cache = rawget(v, "_renderCache")
+    if false == cache then
+        return false
+    end
+
+    local scale = get(rawget(v, "cacheScale")) or 1
+    local width = math.ceil(v.size[1] * scale)
+    local height = math.ceil(v.size[2] * scale)
+
+    if (not cache) or (cache.width ~= width) or (cache.height ~= height) then
+        if cache then
+            unloadImage(cache.texture)
+        end
+        local texture = createRenderTarget(width, height)
+        if not texture then
+            v._renderCache = false
+            return false
+        end
+        cache = { texture = texture, width = width, height = height, 
+            inputs = { }, valid = false }
+        v._renderCache = cache
+    end
+
+    if renderCacheInputsChanged(v, cache) or (not cache.valid) then
+        if not setRenderTarget(cache.texture) then
+            return false
+        end
+        clearRenderTarget(0, 0, 0, 0)
+        saveGraphicsContext()
+        setTranslation(0, 0, width, height, v.size[1], v.size[2])
+        v:draw()
+        restoreGraphicsContext()
+        restoreRenderTarget()
+        cache.valid = true
+    end
+
+    drawTexture(cache.texture, 0, 0, v.size[1], v.size[2], 1, 1, 1, 1)
+    return true
+end
+
+
+-- force component with cacheRender flag to redraw its texture
+function invalidateRenderCache(v)
+    local cache = rawget(v, "_renderCache")
+    if cache then
+        cache.valid = false
+    end
+end
+
+
+-- free render cache textures of component and its subcomponents.
+-- call it for components removed from panel
+function releaseRenderCache(v)
+    local cache = rawget(v, "_renderCache")
+    if cache then
+        unloadImage(cache.texture)
+        v._renderCache = nil
+    end
+    local components = rawget(v, "components")
+    if components then
+        for _, c in ipairs(components) do
+            releaseRenderCache(c)
+        end
+    end
+end
+
+
 -- draw all components from table
 function drawAll(table)
     for _, v in pairs(table) do
-        drawComponent(v)
+        drawComponent(v, table)
+    end
+end
+
+
+-- component functions used while profiler is disabled
+local plainUpdateComponent = updateComponent
+local plainDrawComponent = drawComponent
+
+-- update component and measure time spent
+local function profiledUpdateComponent(v)
+    if v and v.update then
+        local update = v.update
+        profilerBegin(PROFILE_UPDATE, v, update)
+        update(v)
+        profilerEnd()
+    end
+end
+
+-- draw component and measure time spent
+local function profiledDrawComponent(v, list)
+    if v then
+        profilerBegin(PROFILE_DRAW, v, v.draw)
+        plainDrawComponent(v, list)
+        profilerEnd()
+    end
+end
+
+-- called by profiler to install or remove measuring wrappers.
+-- wrappers are not called at all while profiler is disabled
+function setProfilerHooks(enable)
+    if enable then
+        updateComponent = profiledUpdateComponent
+        drawComponent = profiledDrawComponent
+    else
+        updateComponent = plainUpdateComponent
+        drawComponent = plainDrawComponent
     end
 end
 
@@ -524,6 +911,21 @@ function extractFileName(filePath)
 end
 
 
+-- if true compiled scripts are stored in .saslc directories next
+-- to sources and used while sources are not changed
+useBytecodeCache = true
+
+
+-- load script from file, use compiled version if possible
+function loadScript(fileName)
+    if useBytecodeCache then
+        return loadCachedFile(fileName)
+    else
+        return loadfile(fileName)
+    end
+end
+
+
 -- try to find file on search paths
 function openFile(fileName)
     local name = extractFileName(fileName)
@@ -540,8 +942,8 @@ function openFile(fileName)
         end
 
         -- check if it is available at current path
-        if isFileExists(fullName) then
-            local f, errorMsg = loadfile(fullName)
+        if fileExists(fullName) then
+            local f, errorMsg = loadScript(fullName)
             if f then
                 return f
             else
@@ -551,8 +953,8 @@ function openFile(fileName)
 
         -- check subdir
         local subFullName = subdir .. '/' .. fileName
-        if isFileExists(subFullName) then
-            local f, errorMsg = loadfile(subFullName)
+        if fileExists(subFullName) then
+            local f, errorMsg = loadScript(subFullName)
             if f then
                 return f, subdir
             else
@@ -666,27 +1068,129 @@ function resizePopup(width, height)
 end
 
 
+-- if true names of images loaded by panel are stored in images.txt
+-- in panel directory, so next time they are decoded in parallel
+-- before components request them.  existing images.txt is used and
+-- updated even if this flag is false.  only images from panel
+-- directory are listed, their paths are relative to panel directory
+preloadPanelImages = false
+
+-- images loaded while panel is constructed
+local loadedImages = nil
+
+-- images listed in manifest file
+local manifestImages = { }
+
+
+-- start decoding of images listed in manifest file.
+-- returns false if there is no manifest and it shouldn't be created
+local function startImagesPreload(fileName)
+    manifestImages = { }
+
+    local chunk = loadfile(fileName)
+    if not chunk then
+        if preloadPanelImages then
+            loadedImages = { }
+        end
+        return preloadPanelImages
+    end
+    loadedImages = { }
+    local t = { }
+    setfenv(chunk, t)
+    if (not pcall(chunk)) or ('table' ~= type(t.images)) then
+        return true
+    end
+
+    manifestImages = t.images
+    for _, v in ipairs(manifestImages) do
+        local path = panelDir .. '/' .. v
+        if fileExists(path) then
+            preloadImage(path)
+        end
+    end
+    return true
+end
+
+
+-- drop unused preloaded images and update manifest file
+local function finishImagesPreload(fileName)
+    cancelImagePreload()
+
+    local images = { }
+    local prefix = panelDir .. '/'
+    for k, _ in pairs(loadedImages) do
+        if prefix == string.sub(k, 1, #prefix) then
+            table.insert(images, string.sub(k, #prefix + 1))
+        end
+    end
+    loadedImages = nil
+    table.sort(images)
+
+    local changed = #images ~= #manifestImages
+    for i, v in ipairs(images) do
+        changed = changed or (v ~= manifestImages[i])
+    end
+    if not changed then
+        return
+    end
+
+    local f = io.open(fileName, 'w+')
+    if nil ~= f then
+        f:write('images = {\n')
+        for _, v in ipairs(images) do
+            f:write(string.format('%q;\n', v))
+        end
+        f:write('};\n')
+        f:close()
+    else
+        logWarning("Can't open file '" .. fileName .. "' for writing")
+    end
+end
+
+
 -- load panel from file
 -- panel table will be stored in panel global variable
 function loadPanel(fileName, panelWidth, panelHeight, popupWidth, popupHeight)
+    if popups then
+        releaseRenderCache(popups)
+    end
+    if panel then
+        releaseRenderCache(panel)
+    end
+
     popups = createComponent("popups")
     popups.position = createProperty { 0, 0, popupWidth, popupHeight }
     popups.size = { popupWidth, popupHeight }
 
     panelsPositions = loadTableFromFile(panelDir .. '/panels.txt', 'positions')
 
+    -- files could be changed since previous panel was loaded
+    invalidateFileIndex()
+
+    local manifest = panelDir .. '/images.txt'
+    local preloading = startImagesPreload(manifest)
+
     local c = loadComponent("panel", fileName)
+    if c then
+        panel = c({position = { 0, 0, panelWidth, panelHeight}})
+    end
+
+    if preloading then
+        finishImagesPreload(manifest)
+    end
+
     if not c then
         logError("Error loading panel", fileName)
         return nil
     end
-    panel = c({position = { 0, 0, panelWidth, panelHeight}})
 
     return panel
 end
 
 
 -- add path to search path
+-- contents of directories are indexed on first lookup, so adding
+-- of paths doesn't require rescanning of other directories
 function addSearchPath(path)
     table.insert(searchPath, 1, path)
     table.insert(searchImagePath, 1, path)
@@ -748,9 +1252,13 @@ end
 --    center part of image.  width and height sets size of image part
 -- loadImage(fileName, x, y, width, height) - loads specified part of image
 function loadImage(fileName, x, y, width, height)
-    for _, v in ipairs(searchImagePath) do
-        local t = getGLTexture(v .. '/' .. fileName, x, y, width, height)
+    local path = findFile(searchImagePath, fileName)
+    if path then
+        local t = getGLTexture(path, x, y, width, height)
         if t then
+            if loadedImages then
+                loadedImages[path] = true
+            end
             return t
         end
     end
@@ -758,6 +1266,8 @@ function loadImage(fileName, x, y, width, height)
     local tex = getGLTexture(fileName, x, y, width, height)
     if not tex then
         logError("Can't load texture", fileName)
+    elseif loadedImages then
+        loadedImages[fileName] = true
     end
     return tex
 end
@@ -765,8 +1275,9 @@ end
 
 -- load font
 function loadFont(fileName)
-    for _, v in ipairs(searchImagePath) do
-        local t = getGLFont(v .. '/' .. fileName)
+    local path = findFile(searchImagePath, fileName)
+    if path then
+        local t = getGLFont(path)
         if t then
             return t
         end
@@ -810,8 +1321,7 @@ function runHandler(component, name, x, y, button, path)
     end
     local mx = (x - position[1]) * size[1] / position[3]
     local my = (y - position[2]) * size[2] / position[4]
-    for i = #component.components, 1, -1 do
-        local v = component.components[i]
+    for v in childrenAt(component, mx, my) do
         if toboolean(get(v.visible)) and isInRect(get(v.position), mx, my) then
             local res = runHandler(v, name, mx, my, button, path)
             if res then
@@ -841,8 +1351,7 @@ function getFocusedPath(component, x, y, path)
     end
     local mx = (x - position[1]) * size[1] / position[3]
     local my = (y - position[2]) * size[2] / position[4]
-    for i = #component.components, 1, -1 do
-        local v = component.components[i]
+    for v in childrenAt(component, mx, my) do
         if toboolean(get(v.visible)) and isInRect(get(v.position), mx, my) then
             getFocusedPath(v, mx, my, path)
         end
@@ -922,8 +1431,7 @@ function getCursorShape(component, x, y)
     end
     local mx = (x - position[1]) * size[1] / position[3]
     local my = (y - position[2]) * size[2] / position[4]
-    for i = #component.components, 1, -1 do
-        local v = component.components[i]
+    for v in childrenAt(component, mx, my) do
         if toboolean(get(v.visible)) and isInRect(get(v.position), mx, my) then
             local res = getCursorShape(v, mx, my)
             if res then
@@ -1258,6 +1766,12 @@ end
 function doneAvionics()
     callCallbackForAll("onAvionicsDone")
     savePopupsPositions()
+    if popups then
+        releaseRenderCache(popups)
+    end
+    if panel then
+        releaseRenderCache(panel)
+    end
 end
 
 
@@ -1319,14 +1833,12 @@ end
 -- load sample from file
 -- find file using the same rules as for textures
 function loadSample(fileName)
-    for _, v in ipairs(searchImagePath) do
-        local f = v .. '/' .. fileName
-        if isFileExists(f) then
-            return loadSampleFromFile(f)
-        end
+    local path = findFile(searchImagePath, fileName)
+    if path then
+        return loadSampleFromFile(path)
     end
 
-    if not isFileExists(fileName) then
+    if not fileExists(fileName) then
         logError("Can't find sound", fileName)
         return 0
     end
@@ -1351,14 +1863,12 @@ SOUND_EVERYWHERE = 3
 -- load object from file
 -- find file using the same rules as for textures
 function loadObject(fileName)
-    for _, v in ipairs(searchImagePath) do
-        local f = v .. '/' .. fileName
-        if isFileExists(f) then
-            return loadObjectFromFile(f)
-        end
+    local path = findFile(searchImagePath, fileName)
+    if path then
+        return loadObjectFromFile(path)
     end
 
-    if not isFileExists(fileName) then
+    if not fileExists(fileName) then
         logError("Can't find object", fileName)
         return 0
     end
@@ -133,5 +133,109 @@ inline Vector operator * (const Matrix &m1, const Vector &v1)
 }
 
 
+
+// 2D affine transformation packed into 2x3 matrix:
+//   x' = a * x + c * y + tx
+//   y' = b * x + d * y + ty
+// transformations are applied in the same order as for Matrix:
+// new transformation affects coords before current one
+class Affine
+{
+    private:
+        // values
+        float a, b, c, d, tx, ty;
+
+    public:
+        // create identity transformation
+        static Affine identity();
+
+    public:
+        // apply translation before current transformation
+        void translate(float x, float y);
+
+        // apply scale before current transformation
+        void scale(float x, float y);
+
+        // apply rotation before current transformation
+        void rotate(float angle);
+
+        // returns true if transformation is translation only
+        bool isTranslation() const {
+            return (1.0f == a) && (0.0f == b) && (0.0f == c) && (1.0f == d);
+        };
+
+        // transform single point
+        void apply(float &x, float &y) const;
+
+        // transform array of points
+        void apply(float *x, float *y, int count) const;
+};
+
+
+inline Affine Affine::identity()
+{
+    Affine m;
+    m.a = 1.0;  m.c = 0.0;  m.tx = 0.0;
+    m.b = 0.0;  m.d = 1.0;  m.ty = 0.0;
+    return m;
+}
+
+
+inline void Affine::translate(float x, float y)
+{
+    tx += a * x + c * y;
+    ty += b * x + d * y;
+}
+
+
+inline void Affine::scale(float x, float y)
+{
+    a *= x;
+    b *= x;
+    c *= y;
+    d *= y;
+}
+
+
+inline void Affine::rotate(float angle)
+{
+    angle = angle * M_PI / 180.0;
+    float cf = cos(angle);
+    float sf = sin(angle);
+    float na = a * cf + c * sf;
+    float nb = b * cf + d * sf;
+    c = c * cf - a * sf;
+    d = d * cf - b * sf;
+    a = na;
+    b = nb;
+}
+
+
+inline void Affine::apply(float &x, float &y) const
+{
+    float ox = x;
+    x = a * ox + c * y + tx;
+    y = b * ox + d * y + ty;
+}
+
+
+// loops are simple enough to be vectorized by compiler
+inline void Affine::apply(float *x, float *y, int count) const
+{
+    if (isTranslation()) {
+        for (int i = 0; i < count; i++) {
+            x[i] += tx;
+            y[i] += ty;
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            float ox = x[i];
+            x[i] = a * ox + c * y[i] + tx;
+            y[i] = b * ox + d * y[i] + ty;
+        }
+    }
+}
+
+
 #endif
 
@@ -3,14 +3,17 @@
 
 #include <list>
 #include <map>
+#include <set>
 #include <vector>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
 #include <SOIL.h>
 #include "glheaders.h"
 #include "math2d.h"
+#include "texcombiner.h"
 
 
 #if !defined(WIN32) && !defined(__APPLE__)
@@ -44,6 +47,34 @@ static DeleteFramebuffers glDeleteFramebuffers = NULL;
 typedef void (*GenerateMipmap)(GLenum target);
 static GenerateMipmap glGenerateMipmap = NULL;
 
+typedef void (APIENTRY *BlendFuncSeparate)(GLenum srcRGB, GLenum dstRGB,
+        GLenum srcAlpha, GLenum dstAlpha);
+static BlendFuncSeparate glBlendFuncSeparate = NULL;
+
+typedef void (APIENTRY *GenBuffers)(GLsizei n, GLuint *buffers);
+static GenBuffers glGenBuffers = NULL;
+
+typedef void (APIENTRY *BindBuffer)(GLenum target, GLuint buffer);
+static BindBuffer glBindBuffer = NULL;
+
+typedef void (APIENTRY *BufferData)(GLenum target, ptrdiff_t size,
+        const GLvoid *data, GLenum usage);
+static BufferData glBufferData = NULL;
+
+typedef void (APIENTRY *BufferSubData)(GLenum target, ptrdiff_t offset,
+        ptrdiff_t size, const GLvoid *data);
+static BufferSubData glBufferSubData = NULL;
+
+typedef void (APIENTRY *DeleteBuffers)(GLsizei n, const GLuint *buffers);
+static DeleteBuffers glDeleteBuffers = NULL;
+
+typedef GLvoid* (APIENTRY *MapBufferRange)(GLenum target, ptrdiff_t offset,
+        ptrdiff_t length, GLbitfield access);
+static MapBufferRange glMapBufferRange = NULL;
+
+typedef GLboolean (APIENTRY *UnmapBuffer)(GLenum target);
+static UnmapBuffer glUnmapBuffer = NULL;
+
 // opengl defines
 #ifndef GL_DRAW_FRAMEBUFFER_BINDING
 #define GL_DRAW_FRAMEBUFFER_BINDING       GL_FRAMEBUFFER_BINDING
@@ -65,8 +96,65 @@ static GenerateMipmap glGenerateMipmap = NULL;
 #define GL_CLAMP_TO_EDGE                  0x812F
 #endif
 
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER                   0x8892
 #endif
 
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW                    0x88E0
+#endif
+
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT                  0x0002
+#endif
+
+#ifndef GL_MAP_INVALIDATE_RANGE_BIT
+#define GL_MAP_INVALIDATE_RANGE_BIT       0x0004
+#endif
+
+#ifndef GL_MAP_UNSYNCHRONIZED_BIT
+#define GL_MAP_UNSYNCHRONIZED_BIT         0x0020
+#endif
+
+#endif
+
+// width and height of texture atlas pages
+#define ATLAS_PAGE_SIZE 1024
+
+// maximum width and height of image packed into texture atlas
+#define ATLAS_MAX_IMAGE_SIZE 256
+
+// minimal size of streaming vertex buffer object in vertices
+#define VBO_MIN_VERTICES 65536
+
+
+/// Vertex in interleaved vertex buffer
+struct Vertex
+{
+    /// vertex coords
+    GLfloat x, y;
+
+    /// texture coords
+    GLfloat u, v;
+
+    /// vertex color
+    GLubyte r, g, b, a;
+};
+
+
+// blending modes
+enum {
+    // plain colors drawn to screen or plain texture
+    BLEND_NORMAL,
+
+    // plain colors drawn into premultiplied render target
+    BLEND_TO_PREMULTIPLIED,
+
+    // premultiplied render target drawn anywhere
+    BLEND_PREMULTIPLIED
+};
+
+
 // graphics context
 struct OglCanvas
 {
@@ -109,6 +197,16 @@ struct OglCanvas
     /// current texture ID or 0 if texturing disabled
     int currentTexture;
 
+    /// OpenGL texture binded for current texture or 0 if texturing disabled.
+    /// differs from current texture if texture stored in atlas
+    int boundTexture;
+
+    /// texture coords mapping of current texture
+    GLfloat texScaleX, texScaleY, texOffsetX, texOffsetY;
+
+    /// atlas of small textures
+    TexCombiner *combiner;
+
     /// what to draw: GL_LINES or GL_TRIANGLES
     int currentMode;
 
@@ -119,16 +217,33 @@ struct OglCanvas
     int numVertices;
 
     /// vertices buffer
-    GLfloat *vertexBuffer;
+    Vertex *vertexBuffer;
+
+    /// true if vertex buffer objects functions available
+    bool vboAvailable;
 
-    /// texture coords buffer
-    GLfloat *texBuffer;
+    /// true if vertex buffer objects allowed to use
+    bool vboEnabled;
 
-    /// vertex colors buffer
-    GLfloat *colorBuffer;
+    /// true if vertices streamed to vertex buffer object during current frame
+    bool streaming;
 
-    // transformation stack
-    std::vector<Matrix> transform;
+    /// streaming vertex buffer object or 0 if not created yet
+    GLuint vbo;
+
+    /// size of vertex buffer object in vertices
+    int vboSize;
+
+    /// number of vertices written to vertex buffer object since
+    /// last storage reallocation
+    int vboUsed;
+
+    // transformation stack.  entries above transformDepth are kept
+    // allocated so push and pop don't touch heap
+    std::vector<Affine> transform;
+
+    // index of current transformation in stack
+    int transformDepth;
 
     // true if FBO functions allowed to use
     bool fboAvailable;
@@ -136,17 +251,50 @@ struct OglCanvas
     // map of FBOs by texture IDs
     std::map<int, GLuint> fboByTex;
 
-    // default fbo
-    GLuint defaultFbo;
+    // render target saved by set_render_target
+    struct SavedTarget {
+        // fbo which was active before render target switch
+        GLuint fbo;
+
+        // texture assigned to new fbo
+        int texture;
+
+        // blending mode which was active before render target switch
+        int blending;
+    };
+
+    // stack of render targets.  render targets may be nested
+    std::vector<SavedTarget> targets;
 
-    // texture assigned to current fbo
-    int currentFboTex;
+    // textures created by create_texture.  they store colors
+    // premultiplied by alpha
+    std::set<int> premultiplied;
+
+    // current blending mode
+    int blending;
 };
 
 // stores last clip area (x1,y1,width,height)
 GLint  lastClipArea[4];
 
 
+/// setup vertex arrays pointers to vertex buffer object or to
+/// vertices buffer
+static void setArrayPointers(OglCanvas *c)
+{
+    const char *base = (const char*)c->vertexBuffer;
+    if (c->streaming)
+        base = NULL;
+    else if (! base)
+        return;
+
+    glVertexPointer(2, GL_FLOAT, sizeof(Vertex), base + offsetof(Vertex, x));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), base + offsetof(Vertex, u));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex),
+            base + offsetof(Vertex, r));
+}
+
+
 /// initialize graphics before frame start
 static void drawBegin(struct SaslGraphicsCallbacks *canvas)
 {
@@ -158,17 +306,23 @@ static void drawBegin(struct SaslGraphicsCallbacks *canvas)
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    c->blending = BLEND_NORMAL;
     glEnable(GL_TEXTURE_2D);
     c->currentTexture = -1;
 
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    if (c->vertexBuffer) {
-        glVertexPointer(2, GL_FLOAT, 0, c->vertexBuffer);
-        glTexCoordPointer(2, GL_FLOAT, 0, c->texBuffer);
-        glColorPointer(4, GL_FLOAT, 0, c->colorBuffer);
+
+    c->streaming = c->vboAvailable && c->vboEnabled;
+    if (c->streaming) {
+        if (! c->vbo) {
+            glGenBuffers(1, &c->vbo);
+            c->vboSize = c->vboUsed = 0;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, c->vbo);
     }
+    setArrayPointers(c);
 
     c->triangles = 0;
     c->lines = 0;
@@ -181,10 +335,36 @@ static void drawBegin(struct SaslGraphicsCallbacks *canvas)
 
     c->numVertices = 0;
     c->currentTexture = 0;
+    c->boundTexture = 0;
+    c->texScaleX = c->texScaleY = 1.0f;
+    c->texOffsetX = c->texOffsetY = 0.0f;
     c->currentMode = GL_TRIANGLES;
 
-    c->transform.clear();
-    c->transform.push_back(Matrix::identity());
+    c->transformDepth = 0;
+    if (c->transform.empty())
+        c->transform.push_back(Affine::identity());
+    else
+        c->transform[0] = Affine::identity();
+}
+
+
+/// Returns current transformation
+static inline Affine& currentTransform(OglCanvas *c)
+{
+    return c->transform[c->transformDepth];
+}
+
+
+/// Push copy of current transformation or identity transformation
+/// if identity is true
+static void pushTransformState(OglCanvas *c, bool identity)
+{
+    int depth = c->transformDepth + 1;
+    if ((int)c->transform.size() <= depth)
+        c->transform.resize(depth + 1);
+    c->transform[depth] = identity ? Affine::identity() :
+        c->transform[c->transformDepth];
+    c->transformDepth = depth;
 }
 
 
@@ -194,56 +374,143 @@ static void reserveSpace(OglCanvas *c, int qty)
 {
     if (c->numVertices + qty > c->maxVertices) {
         c->maxVertices += (qty / 1024 + 1) * 1024;
-        int s = sizeof(GLfloat) * c->maxVertices;
-        c->vertexBuffer = (GLfloat*)realloc(c->vertexBuffer, 2 * s);
-        c->texBuffer = (GLfloat*)realloc(c->texBuffer, 2 * s);
-        c->colorBuffer = (GLfloat*)realloc(c->colorBuffer, 4 * s);
-
-        glVertexPointer(2, GL_FLOAT, 0, c->vertexBuffer);
-        glTexCoordPointer(2, GL_FLOAT, 0, c->texBuffer);
-        glColorPointer(4, GL_FLOAT, 0, c->colorBuffer);
+        c->vertexBuffer = (Vertex*)realloc(c->vertexBuffer,
+                sizeof(Vertex) * c->maxVertices);
+
+        if (! c->streaming)
+            setArrayPointers(c);
     }
 }
 
 
+/// convert color component to byte
+static GLubyte colorToByte(GLfloat value)
+{
+    if (0.0f >= value)
+        return 0;
+    else if (1.0f <= value)
+        return 255;
+    else
+        return (GLubyte)(value * 255.0f + 0.5f);
+}
+
+
+/// Add already transformed vertex to buffers
+static void putVertex(OglCanvas *c, GLfloat x, GLfloat y,
+        GLfloat r, GLfloat g, GLfloat b, GLfloat a,
+        GLfloat u, GLfloat v)
+{
+    reserveSpace(c, 1);
+
+    Vertex &vertex = c->vertexBuffer[c->numVertices];
+    vertex.x = x;
+    vertex.y = y;
+    vertex.u = u;
+    vertex.v = v;
+    vertex.r = colorToByte(r);
+    vertex.g = colorToByte(g);
+    vertex.b = colorToByte(b);
+    vertex.a = colorToByte(a);
+
+    c->numVertices++;
+}
+
+
 /// Add vertex to buffers
 static void addVertex(OglCanvas *c, GLfloat x, GLfloat y,
         GLfloat r, GLfloat g, GLfloat b, GLfloat a,
         GLfloat u, GLfloat v)
 {
-    reserveSpace(c, 1);
+    currentTransform(c).apply(x, y);
+    putVertex(c, x, y, r, g, b, a, u, v);
+}
 
-    Vector rv = c->transform.back() * Vector(x, y);
-    x = rv.getX();
-    y = rv.getY();
 
-    int i = c->numVertices * 2;
-    c->vertexBuffer[i] = x;
-    c->vertexBuffer[i + 1] = y;
+/// copy accumulated vertices to vertex buffer object.
+/// Returns index of first copied vertex inside of buffer object
+static int streamVertices(OglCanvas *c)
+{
+    if (c->vboUsed + c->numVertices > c->vboSize) {
+        // orphan old storage: driver allocates new one while GPU still
+        // reads vertices of previous batches
+        if (c->numVertices > c->vboSize)
+            c->vboSize = VBO_MIN_VERTICES *
+                (c->numVertices / VBO_MIN_VERTICES + 1);
+        glBufferData(GL_ARRAY_BUFFER, c->vboSize * sizeof(Vertex), NULL,
+                GL_STREAM_DRAW);
+        c->vboUsed = 0;
+    }
 
-    c->texBuffer[i] = u;
-    c->texBuffer[i + 1] = v;
+    int first = c->vboUsed;
+    ptrdiff_t offset = first * sizeof(Vertex);
+    ptrdiff_t size = c->numVertices * sizeof(Vertex);
 
-    i = c->numVertices * 4;
-    c->colorBuffer[i] = r;
-    c->colorBuffer[i + 1] = g;
-    c->colorBuffer[i + 2] = b;
-    c->colorBuffer[i + 3] = a;
+    GLvoid *data = NULL;
+#ifndef __APPLE__
+    // written range never overlaps vertices used by GPU,
+    // so synchronization is not needed
+    if (glMapBufferRange)
+        data = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                GL_MAP_UNSYNCHRONIZED_BIT);
+#endif
+    if (data) {
+        memcpy(data, c->vertexBuffer, size);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else
+        glBufferSubData(GL_ARRAY_BUFFER, offset, size, c->vertexBuffer);
 
-    c->numVertices++;
+    c->vboUsed += c->numVertices;
+    return first;
 }
 
+
 /// draw vertices accumulated in buffers
 static void dumpBuffers(OglCanvas *c)
 {
     if (c->numVertices) {
-        glDrawArrays(c->currentMode, 0, c->numVertices);
+        if (c->streaming)
+            glDrawArrays(c->currentMode, streamVertices(c), c->numVertices);
+        else
+            glDrawArrays(c->currentMode, 0, c->numVertices);
         c->numVertices = 0;
         c->batches++;
     }
 }
 
 
+// select blending mode for current texture and render target.
+// render targets created by create_texture keep colors premultiplied
+// by alpha so alpha is not applied twice when they are drawn.
+static void updateBlending(OglCanvas *c)
+{
+    int blending = BLEND_NORMAL;
+    if (c->premultiplied.count(c->currentTexture))
+        blending = BLEND_PREMULTIPLIED;
+    else if ((! c->targets.empty()) && 
+            c->premultiplied.count(c->targets.back().texture))
+        blending = BLEND_TO_PREMULTIPLIED;
+
+    if (blending == c->blending)
+        return;
+
+    dumpBuffers(c);
+    switch (blending) {
+        case BLEND_NORMAL:
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case BLEND_TO_PREMULTIPLIED:
+            glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+                    GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case BLEND_PREMULTIPLIED:
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+    }
+    c->blending = blending;
+}
+
+
 
 /// flush drawed graphics to screen
 static void drawEnd(struct SaslGraphicsCallbacks *canvas)
@@ -253,6 +520,9 @@ static void drawEnd(struct SaslGraphicsCallbacks *canvas)
 
     dumpBuffers(c);
 
+    if (c->streaming)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
     glPopAttrib();
     glPopClientAttrib();
 /*    printf("textures: %i (%i Kb) triangles: %i lines: %i  batches: %i\n",
@@ -267,30 +537,39 @@ static void drawEnd(struct SaslGraphicsCallbacks *canvas)
 // stop texturing
 static void disableTexture(OglCanvas *c)
 {
-    if (c->currentTexture) {
+    if (c->boundTexture) {
         if (c->numVertices)
             c->batchNoTex++;
         dumpBuffers(c);
         glDisable(GL_TEXTURE_2D);
         c->currentTexture = 0;
+        c->boundTexture = 0;
+        updateBlending(c);
     }
 }
 
 
 // start texturing
+// textures stored in the same atlas page doesn't break batch
 static void setTexture(OglCanvas *c, int texId)
 {
     if (c->currentTexture != texId) {
-        if (c->numVertices)
-            c->batchTex++;
-        dumpBuffers(c);
-        if (! c->currentTexture)
-            glEnable(GL_TEXTURE_2D);
-        if (c->binderCallback)
-            c->binderCallback(texId);
-        else
-            glBindTexture(GL_TEXTURE_2D, texId);
+        int glTexId = c->combiner->mapTexture(texId, c->texScaleX,
+                c->texScaleY, c->texOffsetX, c->texOffsetY);
+        if (c->boundTexture != glTexId) {
+            if (c->numVertices)
+                c->batchTex++;
+            dumpBuffers(c);
+            if (! c->boundTexture)
+                glEnable(GL_TEXTURE_2D);
+            if (c->binderCallback)
+                c->binderCallback(glTexId);
+            else
+                glBindTexture(GL_TEXTURE_2D, glTexId);
+            c->boundTexture = glTexId;
+        }
         c->currentTexture = texId;
+        updateBlending(c);
     }
 }
 
@@ -307,23 +586,59 @@ static void setMode(OglCanvas *c, int mode)
 }
 
 
-/// load texture to memory.
+// returns smallest power of two not less than value
+static int getPowerOfTwo(int value)
+{
+    int res = 1;
+    while (res < value)
+        res *= 2;
+    return res;
+}
+
+
+/// create texture from decoded image.
 /// Returns texture ID or -1 on failure.  On success returns texture width
 //  and height in pixels
-static int loadTexture(struct SaslGraphicsCallbacks *canvas,
-        const char *buffer, int length, int *width, int *height)
+/// small images are stored in texture atlas
+static int loadTexturePixels(struct SaslGraphicsCallbacks *canvas,
+        const unsigned char *data, int imageWidth, int imageHeight, 
+        int channels, int *width, int *height)
 {
     OglCanvas *c = (OglCanvas*)canvas;
-    if (! c)
+    if ((! c) || (! data))
         return -1;
 
+    // texture loading changes binded texture
+    dumpBuffers(c);
+
+    if (c->combiner->canCombine(imageWidth, imageHeight)) {
+        // report the same size as for standalone texture scaled
+        // to power of two, so texture coords stay the same
+        int w = getPowerOfTwo(imageWidth);
+        int h = getPowerOfTwo(imageHeight);
+        int id = c->combiner->addTexture(data, imageWidth, imageHeight,
+                channels, w, h);
+        if (-1 != id) {
+            if (c->boundTexture)
+                c->boundTexture = -1;
+            setTexture(c, id);
+            if (width)
+                *width = w;
+            if (height)
+                *height = h;
+            c->textures++;
+            // image and its border stored in atlas page
+            c->texturesSize += (imageWidth + 2) * (imageHeight + 2);
+            return id;
+        }
+    }
+
     GLuint texId = 0;
     if (c->genTexNameCallback)
         texId = c->genTexNameCallback();
 
-    unsigned id = SOIL_load_OGL_texture_from_memory(
-            (const unsigned char*)buffer, length,
-            0, texId, SOIL_FLAG_POWER_OF_TWO);
+    unsigned id = SOIL_create_OGL_texture(data, imageWidth, imageHeight,
+            channels, texId, SOIL_FLAG_POWER_OF_TWO);
     if (! id)
         return -1;
 
@@ -352,9 +667,46 @@ static int loadTexture(struct SaslGraphicsCallbacks *canvas,
 }
 
 
+/// load texture to memory.
+/// Returns texture ID or -1 on failure.  On success returns texture width
+//  and height in pixels
+static int loadTexture(struct SaslGraphicsCallbacks *canvas,
+        const char *buffer, int length, int *width, int *height)
+{
+    int imageWidth, imageHeight, channels;
+    unsigned char *data = SOIL_load_image_from_memory(
+            (const unsigned char*)buffer, length,
+            &imageWidth, &imageHeight, &channels, SOIL_LOAD_AUTO);
+    if (! data)
+        return -1;
+
+    int id = loadTexturePixels(canvas, data, imageWidth, imageHeight,
+            channels, width, height);
+    SOIL_free_image_data(data);
+    return id;
+}
+
+
 // Unload texture from video memory.
 static void freeTexture(struct SaslGraphicsCallbacks *canvas, int textureId)
 {
+    OglCanvas *c = (OglCanvas*)canvas;
+    assert(canvas);
+
+    // atlas page may be deleted too
+    dumpBuffers(c);
+    c->combiner->removeTexture(textureId);
+    c->currentTexture = -1;
+    if (c->boundTexture)
+        c->boundTexture = -1;
+
+    std::map<int, GLuint>::iterator i = c->fboByTex.find(textureId);
+    if (i != c->fboByTex.end()) {
+        glDeleteFramebuffers(1, &(*i).second);
+        c->fboByTex.erase(i);
+    }
+    c->premultiplied.erase(textureId);
+
     GLuint id = (GLuint)textureId;
     glDeleteTextures(1, &id);
 }
@@ -413,9 +765,108 @@ static void drawTexturedTriangle(struct SaslGraphicsCallbacks *canvas,
     setTexture(c, textureId);
     setMode(c, GL_TRIANGLES);
 
-    addVertex(c,  x1, y1,  r1, g1, b1, a1,  u1, v1);
-    addVertex(c,  x2, y2,  r2, g2, b2, a2,  u2, v2);
-    addVertex(c,  x3, y3,  r3, g3, b3, a3,  u3, v3);
+    GLfloat sx = c->texScaleX, sy = c->texScaleY;
+    GLfloat ox = c->texOffsetX, oy = c->texOffsetY;
+
+    addVertex(c,  x1, y1,  r1, g1, b1, a1,  u1 * sx + ox, v1 * sy + oy);
+    addVertex(c,  x2, y2,  r2, g2, b2, a2,  u2 * sx + ox, v2 * sy + oy);
+    addVertex(c,  x3, y3,  r3, g3, b3, a3,  u3 * sx + ox, v3 * sy + oy);
+}
+
+
+// number of batch vertices transformed at once
+#define TRANSFORM_CHUNK 64
+
+
+// add vertex from batch.  x and y are already transformed
+static void addBatchVertex(OglCanvas *c, GLfloat x, GLfloat y,
+        const float *vertex)
+{
+    putVertex(c, x, y,
+            vertex[4], vertex[5], vertex[6], vertex[7],
+            vertex[2] * c->texScaleX + c->texOffsetX,
+            vertex[3] * c->texScaleY + c->texOffsetY);
+}
+
+
+// transform coords of up to TRANSFORM_CHUNK batch vertices
+static void transformBatch(OglCanvas *c, const float *vertices, int count,
+        GLfloat *x, GLfloat *y)
+{
+    for (int i = 0; i < count; i++) {
+        x[i] = vertices[i * SASL_VERTEX_SIZE];
+        y[i] = vertices[i * SASL_VERTEX_SIZE + 1];
+    }
+    currentTransform(c).apply(x, y, count);
+}
+
+
+// draw batch of primitives
+static void drawVertices(struct SaslGraphicsCallbacks *canvas,
+        int mode, int textureId, const float *vertices, int count)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    if ((! c) || (! vertices) || (0 >= count))
+        return;
+
+    if (-1 == textureId)
+        disableTexture(c);
+    else
+        setTexture(c, textureId);
+
+    const int size = SASL_VERTEX_SIZE;
+    GLfloat x[TRANSFORM_CHUNK], y[TRANSFORM_CHUNK];
+    switch (mode) {
+        case SASL_PRIM_TRIANGLES:
+            setMode(c, GL_TRIANGLES);
+            count -= count % 3;
+            reserveSpace(c, count);
+            c->triangles += count / 3;
+            for (int i = 0; i < count; i += TRANSFORM_CHUNK) {
+                int n = count - i < TRANSFORM_CHUNK ? count - i :
+                    TRANSFORM_CHUNK;
+                transformBatch(c, vertices + i * size, n, x, y);
+                for (int j = 0; j < n; j++)
+                    addBatchVertex(c, x[j], y[j], vertices + (i + j) * size);
+            }
+            break;
+
+        case SASL_PRIM_LINES:
+            setMode(c, GL_LINES);
+            count -= count % 2;
+            reserveSpace(c, count);
+            c->lines += count / 2;
+            for (int i = 0; i < count; i += TRANSFORM_CHUNK) {
+                int n = count - i < TRANSFORM_CHUNK ? count - i :
+                    TRANSFORM_CHUNK;
+                transformBatch(c, vertices + i * size, n, x, y);
+                for (int j = 0; j < n; j++)
+                    addBatchVertex(c, x[j], y[j], vertices + (i + j) * size);
+            }
+            break;
+
+        case SASL_PRIM_QUADS:
+            setMode(c, GL_TRIANGLES);
+            count -= count % 4;
+            reserveSpace(c, count / 2 * 3);
+            c->triangles += count / 2;
+            // corners transformed once and shared by both triangles
+            for (int i = 0; i < count; i += TRANSFORM_CHUNK) {
+                int n = count - i < TRANSFORM_CHUNK ? count - i :
+                    TRANSFORM_CHUNK;
+                transformBatch(c, vertices + i * size, n, x, y);
+                for (int j = 0; j < n; j += 4) {
+                    const float *v = vertices + (i + j) * size;
+                    addBatchVertex(c, x[j], y[j], v);
+                    addBatchVertex(c, x[j + 1], y[j + 1], v + size);
+                    addBatchVertex(c, x[j + 2], y[j + 2], v + 2 * size);
+                    addBatchVertex(c, x[j], y[j], v);
+                    addBatchVertex(c, x[j + 2], y[j + 2], v + 2 * size);
+                    addBatchVertex(c, x[j + 3], y[j + 3], v + 3 * size);
+                }
+            }
+            break;
+    }
 }
 
 
@@ -457,8 +908,7 @@ static void pushTransform(struct SaslGraphicsCallbacks *canvas)
         c->batchTrans++;
     dumpBuffers(c);
     glPushMatrix();*/
-    Matrix m = c->transform.back();
-    c->transform.push_back(m);
+    pushTransformState(c, false);
 }
 
 // pop affine transform state
@@ -470,8 +920,8 @@ static void popTransform(struct SaslGraphicsCallbacks *canvas)
         c->batchTrans++;
     dumpBuffers(c);
     glPopMatrix();*/
-    if (1 < c->transform.size())
-        c->transform.pop_back();
+    if (0 < c->transformDepth)
+        c->transformDepth--;
     else
         printf("invalid pop!\n");
 }
@@ -487,7 +937,7 @@ static void translateTransform(struct SaslGraphicsCallbacks *canvas,
         c->batchTrans++;
     dumpBuffers(c);
     glTranslated(x, y, 0);*/
-    c->transform.back() = Matrix::translate(x, y) * c->transform.back();
+    currentTransform(c).translate(x, y);
 }
 
 
@@ -501,7 +951,7 @@ static void scaleTransform(struct SaslGraphicsCallbacks *canvas,
         c->batchTrans++;
     dumpBuffers(c);
     glScaled(x, y, 1.0f);*/
-    c->transform[c->transform.size() - 1] = Matrix::scale(x, y) * c->transform.back();
+    currentTransform(c).scale(x, y);
 }
 
 // apply rotate transform to current state
@@ -514,7 +964,7 @@ static void rotateTransform(struct SaslGraphicsCallbacks *canvas,
         c->batchTrans++;
     dumpBuffers(c);
     glRotated(angle, 0, 0, -1.0);*/
-    c->transform.back() = Matrix::rotate(-angle) * c->transform.back();
+    currentTransform(c).rotate(-angle);
 }
 
 
@@ -526,9 +976,27 @@ static int findTexture(struct SaslGraphicsCallbacks *canvas,
     OglCanvas *c = (OglCanvas*)canvas;
     assert(canvas);
 
+    // images packed into atlas pages have no storage of their own
+    int rgba[4];
+    if (a && r && g && b) {
+        rgba[0] = *r;
+        rgba[1] = *g;
+        rgba[2] = *b;
+        rgba[3] = *a;
+    }
+    dumpBuffers(c);
+    int packed = c->combiner->findBySize(width, height, 
+            (a && r && g && b) ? rgba : NULL);
+    if (0 < c->boundTexture)
+        glBindTexture(GL_TEXTURE_2D, c->boundTexture);
+    if (-1 != packed)
+        return packed;
+
     unsigned char *buf = new unsigned char[4*width*height];
 
     for (GLuint i = 0; i < 2048; i++) {
+        if (c->combiner->findTexture(i) || c->combiner->isSuperTexture(i))
+            continue;
         if (glIsTexture(i)) {
             GLint w, h;
             glBindTexture(GL_TEXTURE_2D, i);
@@ -540,14 +1008,14 @@ static int findTexture(struct SaslGraphicsCallbacks *canvas,
                     if ((10 > abs(*r - buf[0])) && (10 > abs(*g - buf[1])) &&
                             (10 > abs(*b - buf[2])) && (10 > abs(*a - buf[3])))
                     {
-                        if (c->currentTexture)
-                            glBindTexture(GL_TEXTURE_2D, c->currentTexture);
+                        if (0 < c->boundTexture)
+                            glBindTexture(GL_TEXTURE_2D, c->boundTexture);
                         delete[] buf;
                         return i;
                     }
                 } else {
-                    if (c->currentTexture)
-                        glBindTexture(GL_TEXTURE_2D, c->currentTexture);
+                    if (0 < c->boundTexture)
+                        glBindTexture(GL_TEXTURE_2D, c->boundTexture);
                     delete[] buf;
                     return i;
                 }
@@ -555,8 +1023,8 @@ static int findTexture(struct SaslGraphicsCallbacks *canvas,
         }
     }
 
-    if (c->currentTexture)
-        glBindTexture(GL_TEXTURE_2D, c->currentTexture);
+    if (0 < c->boundTexture)
+        glBindTexture(GL_TEXTURE_2D, c->boundTexture);
     delete[] buf;
 
     return -1;
@@ -600,13 +1068,16 @@ static void prepareFbo(OglCanvas *c, int textureId, int width, int height)
 {
     glClearColor(1.0, 0.0, 0.0, 1.0);
     glViewport(0, 0, width, height);
+    // scissor box of parent render target is meaningless here.
+    // restored with other attributes by set_render_target(-1)
+    glDisable(GL_SCISSOR_TEST);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
     glOrtho(0.0, width, 0.0, height, -1.0, 1.0);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
-    c->transform.push_back(Matrix::identity());
+    pushTransformState(c, true);
 }
 
 
@@ -638,37 +1109,48 @@ static int setRenderTarget(struct SaslGraphicsCallbacks *canvas,
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
 
         // enable fbo
-        c->defaultFbo = getCurrentFbo();
+        OglCanvas::SavedTarget saved;
+        saved.fbo = getCurrentFbo();
+        saved.texture = textureId;
+        saved.blending = c->blending;
         GLuint fbo = getFbo(c, textureId);
         if ((GLuint)-1 == fbo)
             return -1;
-        c->currentFboTex = textureId;
+        c->targets.push_back(saved);
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
         glBindTexture(GL_TEXTURE_2D, 0);
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
                 GL_TEXTURE_2D, textureId, 0);
 
         prepareFbo(c, textureId, w, h);
+        updateBlending(c);
     } else {
-        // restore default fbo
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, c->defaultFbo);
-        glBindTexture(GL_TEXTURE_2D, c->currentFboTex);
-        glGenerateMipmap(GL_TEXTURE);
+        if (c->targets.empty())
+            return -1;
+
+        // restore previous fbo
+        OglCanvas::SavedTarget saved = c->targets.back();
+        c->targets.pop_back();
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, saved.fbo);
+        glBindTexture(GL_TEXTURE_2D, saved.texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
         glBindTexture(GL_TEXTURE_2D, 0);
 
         // restore x-plane state
         glPopClientAttrib();
         glPopAttrib();
+        c->blending = saved.blending;
         glMatrixMode(GL_MODELVIEW);
         glPopMatrix();
         glMatrixMode(GL_PROJECTION);
         glPopMatrix();
         glMatrixMode(GL_MODELVIEW);
 
-        if (c->currentTexture)
-            glBindTexture(GL_TEXTURE_2D, c->currentTexture);
+        if (0 < c->boundTexture)
+            glBindTexture(GL_TEXTURE_2D, c->boundTexture);
 
-        c->transform.pop_back();
+        if (0 < c->transformDepth)
+            c->transformDepth--;
     }
 
     return 0;
@@ -684,6 +1166,14 @@ static void recreateTexture(struct SaslGraphicsCallbacks *canvas,
     OglCanvas *c = (OglCanvas*)canvas;
     assert(canvas);
 
+    // render targets can't live in atlas
+    if (c->combiner->removeTexture(textureId)) {
+        dumpBuffers(c);
+        c->currentTexture = -1;
+        if (c->boundTexture)
+            c->boundTexture = -1;
+    }
+
     glBindTexture(GL_TEXTURE_2D, textureId);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -693,10 +1183,70 @@ static void recreateTexture(struct SaslGraphicsCallbacks *canvas,
             GL_BYTE, NULL);
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    if (c->currentTexture)
-        glBindTexture(GL_TEXTURE_2D, c->currentTexture);
+    if (0 < c->boundTexture)
+        glBindTexture(GL_TEXTURE_2D, c->boundTexture);
+}
+
+// create empty texture suitable for render target.
+// returns texture ID or -1 on errors
+static int createTexture(struct SaslGraphicsCallbacks *canvas,
+        int width, int height)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    assert(canvas);
+
+    if ((! c->fboAvailable) || (0 >= width) || (0 >= height))
+        return -1;
+
+    GLuint texId = 0;
+    if (c->genTexNameCallback)
+        texId = c->genTexNameCallback();
+    else
+        glGenTextures(1, &texId);
+    if (! texId)
+        return -1;
+
+    recreateTexture(canvas, texId, width, height);
+    c->premultiplied.insert(texId);
+    c->textures++;
+
+    return texId;
+}
+
+
+// fill current render target with specified color
+static void clearRenderTarget(struct SaslGraphicsCallbacks *canvas,
+        double r, double g, double b, double a)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    assert(canvas);
+
+    dumpBuffers(c);
+
+    if (c->targets.empty())
+        return;
+
+    glClearColor(r, g, b, a);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+
+// returns number of primitives and batches drawn since frame start
+static void getStatistics(struct SaslGraphicsCallbacks *canvas,
+        int *triangles, int *lines, int *batches)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    assert(canvas);
+
+    if (triangles)
+        *triangles = c->triangles;
+    if (lines)
+        *lines = c->lines;
+    if (batches)
+        *batches = c->batches;
 }
 
+
 #ifndef __APPLE__
 // returns address of OpenGL functions.  check EXT variants if normal not found
 typedef void (*Func)();
@@ -729,9 +1279,26 @@ static bool initGlFunctions()
     glFramebufferTexture2D = (FramebufferTexture2D)getProcAddress("glFramebufferTexture2D");
     glDeleteFramebuffers = (DeleteFramebuffers)getProcAddress("glDeleteFramebuffers");
     glGenerateMipmap = (GenerateMipmap)getProcAddress("glGenerateMipmap");
+    glBlendFuncSeparate = (BlendFuncSeparate)getProcAddress("glBlendFuncSeparate");
 
     return glGenFramebuffers && glBindFramebuffer && glFramebufferTexture2D &&
-        glDeleteFramebuffers && glGenerateMipmap;
+        glDeleteFramebuffers && glGenerateMipmap && glBlendFuncSeparate;
+}
+
+
+// find pointers of vertex buffer objects functions
+static bool initVboFunctions()
+{
+    glGenBuffers = (GenBuffers)getProcAddress("glGenBuffers");
+    glBindBuffer = (BindBuffer)getProcAddress("glBindBuffer");
+    glBufferData = (BufferData)getProcAddress("glBufferData");
+    glBufferSubData = (BufferSubData)getProcAddress("glBufferSubData");
+    glDeleteBuffers = (DeleteBuffers)getProcAddress("glDeleteBuffers");
+    glUnmapBuffer = (UnmapBuffer)getProcAddress("glUnmapBuffer");
+    glMapBufferRange = (MapBufferRange)getProcAddress("glMapBufferRange");
+
+    return glGenBuffers && glBindBuffer && glBufferData && glBufferSubData &&
+        glDeleteBuffers && glUnmapBuffer;
 }
 
 #else
@@ -741,6 +1308,11 @@ static bool initGlFunctions()
     return 1;
 }
 
+static bool initVboFunctions()
+{
+    return 1;
+}
+
 #endif
 
 
@@ -766,10 +1338,28 @@ struct SaslGraphicsCallbacks* saslgl_init_graphics()
     c->callbacks.find_texture = findTexture;
     c->callbacks.set_render_target = setRenderTarget;
     c->callbacks.recreate_texture = recreateTexture;
+    c->callbacks.version = SASL_GRAPHICS_VERSION;
+    c->callbacks.draw_vertices = drawVertices;
+    c->callbacks.create_texture = createTexture;
+    c->callbacks.clear_render_target = clearRenderTarget;
+    c->callbacks.get_statistics = getStatistics;
+    c->callbacks.load_texture_pixels = loadTexturePixels;
+
+    c->binderCallback = NULL;
+    c->genTexNameCallback = NULL;
+    c->combiner = new TexCombiner(ATLAS_PAGE_SIZE, ATLAS_MAX_IMAGE_SIZE);
 
     c->maxVertices = c->numVertices = 0;
-    c->vertexBuffer = c->texBuffer = c->colorBuffer = NULL;
+    c->vertexBuffer = NULL;
     c->fboAvailable = initGlFunctions();
+    c->vboAvailable = initVboFunctions();
+    c->vboEnabled = true;
+    c->streaming = false;
+    c->vbo = 0;
+    c->vboSize = c->vboUsed = 0;
+    c->transform.push_back(Affine::identity());
+    c->transformDepth = 0;
+    c->blending = BLEND_NORMAL;
 
     return (struct SaslGraphicsCallbacks*)c;
 }
@@ -786,9 +1376,11 @@ void saslgl_done_graphics(struct SaslGraphicsCallbacks *canvas)
                 glDeleteFramebuffers(1, &(*i).second);
         }
 
+        if (c->vbo)
+            glDeleteBuffers(1, &c->vbo);
+
+        delete c->combiner;
         free(c->vertexBuffer);
-        free(c->texBuffer);
-        free(c->colorBuffer);
         delete c;
     }
 }
@@ -800,6 +1392,7 @@ void saslgl_set_texture2d_binder_callback(struct SaslGraphicsCallbacks *canvas,
     if (! c)
         return;
     c->binderCallback = binder;
+    c->combiner->setCallbacks(c->binderCallback, c->genTexNameCallback);
 }
 
 /// Setup texture name generator function.
@@ -812,4 +1405,31 @@ void saslgl_set_gen_tex_name_callback(struct SaslGraphicsCallbacks *canvas,
     if (! c)
         return;
     c->genTexNameCallback = generator;
+    c->combiner->setCallbacks(c->binderCallback, c->genTexNameCallback);
+}
+
+
+/// Setup texture atlas.
+/// \param canvas graphics canvas.
+/// \param maxImageSize maximum width and height of image stored in atlas.
+///     pass 0 to disable atlas.
+void saslgl_set_texture_atlas(struct SaslGraphicsCallbacks *canvas,
+        int maxImageSize)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    if (! c)
+        return;
+    c->combiner->setMaxImageSize(maxImageSize);
+}
+
+
+/// Enable or disable streaming of vertices through vertex buffer object
+/// \param canvas graphics canvas.
+/// \param enable if non-zero vertex buffer object will be used if available.
+void saslgl_set_vbo_enabled(struct SaslGraphicsCallbacks *canvas, int enable)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    if (! c)
+        return;
+    c->vboEnabled = enable;
 }
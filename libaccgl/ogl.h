@@ -40,6 +40,21 @@ void saslgl_set_texture2d_binder_callback(struct SaslGraphicsCallbacks *canvas,
 void saslgl_set_gen_tex_name_callback(struct SaslGraphicsCallbacks *canvas, 
         saslgl_gen_tex_name_callback generator);
 
+/// Setup texture atlas.  Small images are packed into shared textures
+/// so drawing them doesn't require texture switch.  Atlas enabled by default.
+/// \param canvas graphics canvas.
+/// \param maxImageSize maximum width and height of image stored in atlas.
+///     pass 0 to disable atlas.
+void saslgl_set_texture_atlas(struct SaslGraphicsCallbacks *canvas,
+        int maxImageSize);
+
+/// Enable or disable streaming of vertices through vertex buffer object.
+/// Client side vertex arrays are used if disabled or if vertex buffer
+/// objects are not supported.  Enabled by default.
+/// \param canvas graphics canvas.
+/// \param enable if non-zero vertex buffer object will be used if available.
+void saslgl_set_vbo_enabled(struct SaslGraphicsCallbacks *canvas, int enable);
+
 
 
 
@@ -0,0 +1,68 @@
+#include "supertexture.h"
+
+#include <stdlib.h>
+
+
+
+void SubTexture::getMapping(float &scaleX, float &scaleY,
+        float &offsetX, float &offsetY) const
+{
+    float w = parent->getWidth();
+    float h = parent->getHeight();
+    scaleX = imageWidth / w;
+    scaleY = imageHeight / h;
+    offsetX = posX / w;
+    offsetY = posY / h;
+}
+
+
+void SubTexture::mapTexCoords(float ox1, float oy1, float ox2, float oy2,
+        float &dx1, float &dy1, float &dx2, float &dy2) const
+{
+    float scaleX, scaleY, offsetX, offsetY;
+    getMapping(scaleX, scaleY, offsetX, offsetY);
+    dx1 = ox1 * scaleX + offsetX;
+    dy1 = oy1 * scaleY + offsetY;
+    dx2 = ox2 * scaleX + offsetX;
+    dy2 = oy2 * scaleY + offsetY;
+}
+
+
+
+bool SuperTexture::allocate(int w, int h, int &x, int &y)
+{
+    if ((w > width) || (h > height))
+        return false;
+
+    // find lowest row which is high enough and not wasting too much space
+    Shelf *best = NULL;
+    for (std::vector<Shelf>::iterator i = shelves.begin();
+            i != shelves.end(); i++)
+    {
+        Shelf &s = *i;
+        if ((s.height >= h) && (s.height <= h + h / 2 + 2) &&
+                (width - s.used >= w))
+        {
+            if ((! best) || (s.height < best->height))
+                best = &s;
+        }
+    }
+
+    if (! best) {
+        if (height - usedHeight < h)
+            return false;
+        Shelf s;
+        s.y = usedHeight;
+        s.height = h;
+        s.used = 0;
+        usedHeight += h;
+        shelves.push_back(s);
+        best = &shelves.back();
+    }
+
+    x = best->used;
+    y = best->y;
+    best->used += w;
+    return true;
+}
+
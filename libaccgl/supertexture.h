@@ -17,31 +17,56 @@ class SubTexture: public Texture
         /// Parent super texture
         SuperTexture *parent;
 
-        /// X-position inside of super texture
+        /// X-position of image inside of super texture
         int posX;
 
-        /// Y-position inside of super texture
+        /// Y-position of image inside of super texture
         int posY;
 
+        /// Width of image stored in super texture
+        int imageWidth;
+
+        /// Height of image stored in super texture
+        int imageHeight;
+
     public:
         /// Create subtexture
-        SubTexture(int id, int width, int height, SuperTexture *parent): 
-            Texture(id, width, height), parent(parent), posX(0), posY(0) 
+        /// \param id texture ID visible to texture users.
+        /// \param width texture width reported to texture users.
+        /// \param height texture height reported to texture users.
+        /// \param imageWidth width of image stored in super texture.
+        /// \param imageHeight height of image stored in super texture.
+        /// \param parent super texture which stores image.
+        SubTexture(int id, int width, int height, int imageWidth,
+                int imageHeight, SuperTexture *parent):
+            Texture(id, width, height), parent(parent), posX(0), posY(0),
+            imageWidth(imageWidth), imageHeight(imageHeight)
                 { };
 
     public:
         /// Returns parent super texture
-        SuperTexture* getParent() const { return parent};
+        SuperTexture* getParent() const { return parent; };
 
         /// Returns X-position inside of super texture
         int getX() const { return posX; };
-        
+
         /// Returns Y-position inside of super texture
         int getY() const { return posY; };
 
+        /// Returns width of image stored in super texture
+        int getImageWidth() const { return imageWidth; };
+
+        /// Returns height of image stored in super texture
+        int getImageHeight() const { return imageHeight; };
+
         /// Set position inside of super texture
         void setPosition(int x, int y) { posX = x; posY = y; };
 
+        /// Returns scale and offset which converts subtexture coords into
+        /// super texture coords
+        void getMapping(float &scaleX, float &scaleY,
+                float &offsetX, float &offsetY) const;
+
         /// Map texture coords from subtexture into super texture
         void mapTexCoords(float ox1, float oy1, float ox2, float oy2,
             float &dx1, float &dy1, float &dx2, float &dy2) const;
@@ -53,23 +78,47 @@ class SubTexture: public Texture
 class SuperTexture: public Texture
 {
     private:
-        /// list of subtextures
-        std::vector<SubTexture> subTextures;
+        /// Row of images of the same height
+        struct Shelf
+        {
+            /// Y-position of row
+            int y;
+
+            /// Height of row
+            int height;
+
+            /// Width of row used by images
+            int used;
+        };
+
+        /// List of rows allocated in texture
+        std::vector<Shelf> shelves;
+
+        /// Height of texture used by rows
+        int usedHeight;
+
+        /// Number of subtextures stored in texture
+        int subTexturesCount;
 
     public:
-        SuperTexture(int id, int width, int height): Texture(id, width, height)
-                { };
+        SuperTexture(int id, int width, int height): Texture(id, width, height),
+                usedHeight(0), subTexturesCount(0) { };
 
     public:
-        /// Add subtextures into texture
-        /// Returns list of combined textures
-        /// Removes combined textures from its argument
-        std::vector<std::pair<int, SubTexture*> > combine(std::vector<std::pair<int, Texture> >& textures);
-        
-        /// Map single texture to super texture
-        /// Returns super texture ID
-        int mapTexture(int oldTexId, float ox1, float oy1, float ox2, float oy2,
-            float &dx1, float &dy1, float &dx2, float &dy2);
+        /// Find free space for image of specified size.
+        /// Returns false if image doesn't fit into texture.
+        /// Space released by removed images is not reused until
+        /// entire super texture became empty.
+        bool allocate(int width, int height, int &x, int &y);
+
+        /// Increase number of subtextures stored in texture
+        void addSubTexture() { subTexturesCount++; };
+
+        /// Decrease number of subtextures stored in texture
+        void removeSubTexture() { subTexturesCount--; };
+
+        /// Returns true if texture doesn't contains any subtextures
+        bool isEmpty() const { return ! subTexturesCount; };
 };
 
 
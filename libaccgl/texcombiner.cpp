@@ -0,0 +1,293 @@
+#include "texcombiner.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include "glheaders.h"
+
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE                  0x812F
+#endif
+
+
+// convert pixel to RGBA format
+static void copyPixel(unsigned char *dest, const unsigned char *src,
+        int channels)
+{
+    switch (channels) {
+        case 1:
+            dest[0] = dest[1] = dest[2] = src[0];
+            dest[3] = 255;
+            break;
+        case 2:
+            dest[0] = dest[1] = dest[2] = src[0];
+            dest[3] = src[1];
+            break;
+        case 3:
+            dest[0] = src[0];
+            dest[1] = src[1];
+            dest[2] = src[2];
+            dest[3] = 255;
+            break;
+        default:
+            memcpy(dest, src, 4);
+    }
+}
+
+
+TexCombiner::TexCombiner(int pageSize, int maxImageSize):
+    pageSize(pageSize), binder(NULL), generator(NULL)
+{
+    setMaxImageSize(maxImageSize);
+}
+
+
+TexCombiner::~TexCombiner()
+{
+    for (std::map<int, SubTexture*>::iterator i = combined.begin();
+            i != combined.end(); i++)
+        delete (*i).second;
+
+    for (std::vector<SuperTexture*>::iterator i = superTextures.begin();
+            i != superTextures.end(); i++)
+    {
+        GLuint id = (*i)->getId();
+        glDeleteTextures(1, &id);
+        delete *i;
+    }
+}
+
+
+void TexCombiner::setCallbacks(saslgl_bind_texture_2d_callback binder,
+        saslgl_gen_tex_name_callback generator)
+{
+    this->binder = binder;
+    this->generator = generator;
+}
+
+
+void TexCombiner::setMaxImageSize(int size)
+{
+    // leave space for image border
+    if (size > pageSize - 2)
+        size = pageSize - 2;
+    if (0 > size)
+        size = 0;
+    maxImageSize = size;
+}
+
+
+bool TexCombiner::canCombine(int width, int height) const
+{
+    return (0 < width) && (0 < height) && (width <= maxImageSize) &&
+        (height <= maxImageSize);
+}
+
+
+int TexCombiner::genTexName()
+{
+    if (generator)
+        return generator();
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    return id;
+}
+
+
+void TexCombiner::bindTexture(int texId)
+{
+    if (binder)
+        binder(texId);
+    else
+        glBindTexture(GL_TEXTURE_2D, texId);
+}
+
+
+SuperTexture* TexCombiner::createSuperTexture()
+{
+    int id = genTexName();
+    if (! id)
+        return NULL;
+
+    bindTexture(id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, pageSize, pageSize, 0, GL_RGBA,
+            GL_UNSIGNED_BYTE, NULL);
+
+    SuperTexture *texture = new SuperTexture(id, pageSize, pageSize);
+    superTextures.push_back(texture);
+    return texture;
+}
+
+
+int TexCombiner::addTexture(const unsigned char *data, int imageWidth,
+        int imageHeight, int channels, int width, int height)
+{
+    if ((! data) || (! canCombine(imageWidth, imageHeight)) ||
+            (1 > channels) || (4 < channels))
+        return -1;
+
+    // image stored with one pixel border to avoid bleeding of
+    // neighbour images on linear filtering
+    int w = imageWidth + 2;
+    int h = imageHeight + 2;
+
+    SuperTexture *parent = NULL;
+    int x = 0, y = 0;
+    for (std::vector<SuperTexture*>::iterator i = superTextures.begin();
+            i != superTextures.end(); i++)
+    {
+        if ((*i)->allocate(w, h, x, y)) {
+            parent = *i;
+            break;
+        }
+    }
+    if (! parent) {
+        parent = createSuperTexture();
+        if ((! parent) || (! parent->allocate(w, h, x, y)))
+            return -1;
+    }
+
+    int id = genTexName();
+    if (! id)
+        return -1;
+
+    unsigned char *buf = new unsigned char[w * h * 4];
+    for (int row = 0; row < h; row++) {
+        int srcRow = row - 1;
+        if (0 > srcRow)
+            srcRow = 0;
+        else if (srcRow >= imageHeight)
+            srcRow = imageHeight - 1;
+        const unsigned char *src = data + srcRow * imageWidth * channels;
+        unsigned char *dest = buf + row * w * 4;
+        copyPixel(dest, src, channels);
+        for (int col = 0; col < imageWidth; col++)
+            copyPixel(dest + (col + 1) * 4, src + col * channels, channels);
+        copyPixel(dest + (w - 1) * 4, src + (imageWidth - 1) * channels,
+                channels);
+    }
+
+    bindTexture(parent->getId());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA,
+            GL_UNSIGNED_BYTE, buf);
+    delete[] buf;
+
+    SubTexture *texture = new SubTexture(id, width, height, imageWidth,
+            imageHeight, parent);
+    texture->setPosition(x + 1, y + 1);
+    parent->addSubTexture();
+    combined[id] = texture;
+
+    return id;
+}
+
+
+SubTexture* TexCombiner::findTexture(int texId) const
+{
+    std::map<int, SubTexture*>::const_iterator i = combined.find(texId);
+    if (i == combined.end())
+        return NULL;
+    else
+        return (*i).second;
+}
+
+
+bool TexCombiner::isSuperTexture(int texId) const
+{
+    for (std::vector<SuperTexture*>::const_iterator i = superTextures.begin();
+            i != superTextures.end(); i++)
+        if ((*i)->getId() == texId)
+            return true;
+    return false;
+}
+
+
+int TexCombiner::findBySize(int width, int height, const int *rgba)
+{
+    SuperTexture *loaded = NULL;
+    std::vector<unsigned char> pixels;
+    int found = -1;
+
+    for (std::map<int, SubTexture*>::iterator i = combined.begin();
+            i != combined.end(); i++)
+    {
+        SubTexture *texture = (*i).second;
+        if ((texture->getWidth() != width) || 
+                (texture->getHeight() != height))
+            continue;
+        if (! rgba) {
+            found = texture->getId();
+            break;
+        }
+
+        // marker is first pixel of image inside of super texture
+        SuperTexture *parent = texture->getParent();
+        if (parent != loaded) {
+            pixels.resize(parent->getWidth() * parent->getHeight() * 4);
+            bindTexture(parent->getId());
+            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, 
+                    &pixels[0]);
+            loaded = parent;
+        }
+        const unsigned char *p = &pixels[(texture->getY() * 
+                parent->getWidth() + texture->getX()) * 4];
+        if ((10 > abs(rgba[0] - p[0])) && (10 > abs(rgba[1] - p[1])) &&
+                (10 > abs(rgba[2] - p[2])) && (10 > abs(rgba[3] - p[3])))
+        {
+            found = texture->getId();
+            break;
+        }
+    }
+
+    return found;
+}
+
+
+bool TexCombiner::removeTexture(int texId)
+{
+    std::map<int, SubTexture*>::iterator i = combined.find(texId);
+    if (i == combined.end())
+        return false;
+
+    SubTexture *texture = (*i).second;
+    SuperTexture *parent = texture->getParent();
+    combined.erase(i);
+    delete texture;
+
+    parent->removeSubTexture();
+    if (parent->isEmpty()) {
+        for (std::vector<SuperTexture*>::iterator j = superTextures.begin();
+                j != superTextures.end(); j++)
+        {
+            if (*j == parent) {
+                superTextures.erase(j);
+                break;
+            }
+        }
+        GLuint id = parent->getId();
+        glDeleteTextures(1, &id);
+        delete parent;
+    }
+
+    return true;
+}
+
+
+int TexCombiner::mapTexture(int texId, float &scaleX, float &scaleY,
+        float &offsetX, float &offsetY) const
+{
+    SubTexture *texture = findTexture(texId);
+    if (! texture) {
+        scaleX = scaleY = 1.0f;
+        offsetX = offsetY = 0.0f;
+        return texId;
+    } else {
+        texture->getMapping(scaleX, scaleY, offsetX, offsetY);
+        return texture->getParent()->getId();
+    }
+}
+
@@ -0,0 +1,102 @@
+#ifndef __TEX_COMBINER_H__
+#define __TEX_COMBINER_H__
+
+
+#include "supertexture.h"
+#include "ogl.h"
+
+#include <map>
+
+
+/// Combines small textures into bigger ones.
+/// Drawing images stored in the same super texture doesn't require
+/// texture switch, so whole panel may be drawn using few batches
+class TexCombiner
+{
+    private:
+        /// list of available super textures
+        std::vector<SuperTexture*> superTextures;
+
+        /// combined textures mapped by its id
+        std::map<int, SubTexture*> combined;
+
+        /// Width and height of super textures
+        int pageSize;
+
+        /// Maximum width and height of image to combine
+        int maxImageSize;
+
+        /// texture binder function (or NULL if not available)
+        saslgl_bind_texture_2d_callback binder;
+
+        /// texture ID generator (or NULL if not available)
+        saslgl_gen_tex_name_callback generator;
+
+    public:
+        /// Create new texture combiner instance
+        /// \param pageSize width and height of super textures.
+        /// \param maxImageSize maximum size of image to combine.
+        TexCombiner(int pageSize, int maxImageSize);
+
+        /// Delete all super textures
+        ~TexCombiner();
+
+    public:
+        /// Setup OpenGL callbacks
+        void setCallbacks(saslgl_bind_texture_2d_callback binder,
+                saslgl_gen_tex_name_callback generator);
+
+        /// Set maximum size of image to combine.
+        /// Pass 0 to stop combining of new textures
+        void setMaxImageSize(int size);
+
+        /// Returns true if image of specified size could be combined
+        bool canCombine(int width, int height) const;
+
+        /// Copy image into one of super textures.
+        /// Returns ID of new texture or -1 on failure
+        /// \param data image pixels.
+        /// \param imageWidth image width in pixels.
+        /// \param imageHeight image height in pixels.
+        /// \param channels number of bytes per pixel.
+        /// \param width texture width reported to texture users.
+        /// \param height texture height reported to texture users.
+        int addTexture(const unsigned char *data, int imageWidth,
+                int imageHeight, int channels, int width, int height);
+
+        /// Returns combined texture or NULL if texture wasn't combined
+        SubTexture* findTexture(int texId) const;
+
+        /// Returns true if texture is one of super textures
+        bool isSuperTexture(int texId) const;
+
+        /// Find combined texture by reported size and color of its
+        /// first pixel.  Returns texture ID or -1 if not found
+        /// \param width texture width reported to texture users.
+        /// \param height texture height reported to texture users.
+        /// \param rgba marker color or NULL to match by size only.
+        int findBySize(int width, int height, const int *rgba);
+
+        /// Forget about combined texture.
+        /// Returns true if texture was combined.
+        bool removeTexture(int texId);
+
+        /// Map single texture to super texture
+        /// Returns super texture ID or texture ID if it wasn't combined.
+        int mapTexture(int texId, float &scaleX, float &scaleY,
+                float &offsetX, float &offsetY) const;
+
+    private:
+        /// Create new empty super texture
+        SuperTexture* createSuperTexture();
+
+        /// Generate new texture name
+        int genTexName();
+
+        /// Bind texture
+        void bindTexture(int texId);
+};
+
+
+#endif
+
@@ -11,24 +11,24 @@ class Texture
 
         /// Texture width in pixels
         int width;
-        
+
         /// Texture height in pixels
         int height;
 
     public:
-        /// Create subtexture with specified ID and size
-        SubTexture(int id, int width, int height): id(id), width(width),
+        /// Create texture with specified ID and size
+        Texture(int id, int width, int height): id(id), width(width),
                 height(height) { };
 
-        virtual ~SubTexture() { };
+        virtual ~Texture() { };
 
     public:
         /// Return OpenGL texture ID
         int getId() const { return id; };
-        
+
         /// Returns width of texture in pixels
         int getWidth() const { return width; };
-        
+
         /// Returns height of texture in pixels
         int getHeight() const { return height; };
 };
@@ -7,6 +7,8 @@
 #include "utils.h"
 #include "graphstub.h"
 #include "sound.h"
+#include "hitindex.h"
+#include "propgroup.h"
 
 
 using namespace xa;
@@ -17,13 +19,13 @@ Avionics::Avionics(const std::string &path,
         sasl_lua_destroyer_callback luaDestroyer): path(path), 
     lua(luaCreator, luaDestroyer), clickEmulator(timer),
     fontManager(textureManager), properties(lua), server(log, properties), 
-    commands(lua)
+    commands(lua), profiler(lua, log),
+    collector(lua)
 {
     log.exportToLua(lua);
     panelWidth = popupWidth = 1024;
     panelHeight = popupHeight = 768;
     setGraphicsCallbacks(getGraphicsStub());
-    lastGcTime = 0;
 
     bgR = bgG = bgB = 1.0f;
     bgA = 0.0f;
@@ -34,6 +36,12 @@ Avionics::Avionics(const std::string &path,
     exportFontToLua(lua);
     exportPropsToLua(lua);
     sound.exportSoundToLua(lua);
+    exportHitIndexToLua(lua);
+    exportPropGroupToLua(lua);
+    exportPropsStatsToLua(lua);
+    exportProfilerToLua(lua);
+    exportCollectorToLua(lua);
+    exportFileIndexToLua(lua);
 
     clickEmulation = false;
 }
@@ -131,6 +139,8 @@ int Avionics::loadPanel(const std::string &fileName)
 
 void Avionics::update()
 {
+    profiler.startFrame();
+
     if (properties.update())
         log.error("Error updating properties");
 
@@ -157,11 +167,9 @@ void Avionics::update()
     } else
         lua_pop(L, 1);
 
-    long currentTime = timer.getTime();
-    if (currentTime - lastGcTime > 3000) {
-//        lua_gc(L, LUA_GCCOLLECT, 0);
-        lastGcTime = currentTime;
-    }
+    properties.flush();
+
+    collector.onUpdate();
 }
 
 void Avionics::draw(int stage)
@@ -197,6 +205,8 @@ void Avionics::draw(int stage)
     }
     
     graphics->draw_end(graphics);
+
+    collector.onDraw();
 }
 
 void Avionics::addSearchPath(const std::string &path)
@@ -377,6 +387,7 @@ void Avionics::setGraphicsCallbacks(SaslGraphicsCallbacks *callbacks)
 {
     graphics = callbacks;
     textureManager.setGraphicsCallbacks(callbacks);
+    profiler.setGraphics(callbacks);
 }
 
 
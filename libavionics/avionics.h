@@ -14,6 +14,9 @@
 #include "commands.h"
 #include "log.h"
 #include "sound.h"
+#include "profiler.h"
+#include "collector.h"
+#include "fileindex.h"
 
 
 namespace xa {
@@ -74,12 +77,18 @@ class Avionics
         /// Graphics functions
         SaslGraphicsCallbacks *graphics;
 
-        /// Time passed since last garbage collection
-        long lastGcTime;
-
         /// Sound related functions
         Sound sound;
 
+        /// Per-component time measurement
+        Profiler profiler;
+
+        /// Lua garbage collection policy
+        Collector collector;
+
+        /// Cache of search paths contents
+        FileIndex fileIndex;
+
     public:
         /// Initialize avionics internal data
         Avionics(const std::string &path, 
@@ -195,6 +204,15 @@ class Avionics
         /// Returns sound API object
         Sound& getSound() { return sound; };
 
+        /// Returns components profiler
+        Profiler& getProfiler() { return profiler; };
+
+        /// Returns garbage collector
+        Collector& getCollector() { return collector; };
+
+        /// Returns cache of search paths contents
+        FileIndex& getFileIndex() { return fileIndex; };
+
     private:
         /// Add path to components search list
         void addSearchPath(const std::string &path);
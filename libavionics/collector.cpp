@@ -0,0 +1,176 @@
+#include "collector.h"
+
+#include "libavionics.h"
+#include "avionics.h"
+
+
+using namespace xa;
+
+
+/// Size of single incremental step in Kb
+#define GC_STEP_SIZE 8
+
+/// New cycle starts when heap grows to this percent of heap size
+/// after last cycle (same meaning as Lua collector pause)
+#define GC_PAUSE 200
+
+/// Cycle finished at once if heap grows to this percent of heap size
+/// after last cycle because incremental steps are too slow
+#define GC_LIMIT 400
+
+
+
+Collector::Collector(Luna &lua): lua(lua)
+{
+    budget = 0;
+    afterDraw = false;
+    pending = false;
+    collecting = false;
+    lastHeap = 0;
+    cycles = fullCollections = steps = 0;
+    totalTime = lastPause = maxPause = 0;
+}
+
+
+void Collector::setPolicy(int budget, bool afterDraw)
+{
+    lua_State *L = lua.getLua();
+
+    this->budget = budget / 1000.0;
+    this->afterDraw = afterDraw;
+    pending = false;
+
+    if (0 < budget) {
+        lua_gc(L, LUA_GCSTOP, 0);
+        lastHeap = lua_gc(L, LUA_GCCOUNT, 0);
+    } else {
+        this->budget = 0;
+        collecting = false;
+        lua_gc(L, LUA_GCRESTART, 0);
+    }
+}
+
+
+void Collector::onUpdate()
+{
+    if (0 >= budget)
+        return;
+
+    // collect even if nothing was drawn since last update
+    if ((! afterDraw) || pending)
+        collect();
+    pending = true;
+}
+
+
+void Collector::onDraw()
+{
+    if ((0 < budget) && afterDraw && pending)
+        collect();
+}
+
+
+void Collector::collect()
+{
+    lua_State *L = lua.getLua();
+
+    pending = false;
+
+    int heap = lua_gc(L, LUA_GCCOUNT, 0);
+    if (! collecting) {
+        if (heap < lastHeap * GC_PAUSE / 100)
+            return;
+        collecting = true;
+    }
+
+    double start = timer.getPreciseTime();
+    do {
+        steps++;
+        if (lua_gc(L, LUA_GCSTEP, GC_STEP_SIZE)) {
+            collecting = false;
+            cycles++;
+            break;
+        }
+    } while (timer.getPreciseTime() - start < budget);
+
+    // allocations are faster than incremental collection
+    if (collecting && (heap >= lastHeap * GC_LIMIT / 100)) {
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        collecting = false;
+        cycles++;
+        fullCollections++;
+    }
+
+    if (! collecting)
+        lastHeap = lua_gc(L, LUA_GCCOUNT, 0);
+
+    // incremental step restarts automatic collection
+    lua_gc(L, LUA_GCSTOP, 0);
+
+    lastPause = timer.getPreciseTime() - start;
+    totalTime += lastPause;
+    if (lastPause > maxPause)
+        maxPause = lastPause;
+}
+
+
+void Collector::getStats(struct SaslGcStats *stats)
+{
+    if (! stats)
+        return;
+
+    stats->heapSize = lua_gc(lua.getLua(), LUA_GCCOUNT, 0);
+    stats->cycles = cycles;
+    stats->fullCollections = fullCollections;
+    stats->steps = steps;
+    stats->totalTime = totalTime;
+    stats->lastPause = lastPause;
+    stats->maxPause = maxPause;
+}
+
+
+
+/// Set garbage collection policy.  Arguments are time budget in
+/// microseconds and true to collect garbage after draw
+static int luaSetGcPolicy(lua_State *L)
+{
+    getAvionics(L)->getCollector().setPolicy((int)lua_tonumber(L, 1),
+            lua_toboolean(L, 2));
+    return 0;
+}
+
+
+/// Returns table with garbage collector statistics
+static int luaGetGcStats(lua_State *L)
+{
+    SaslGcStats stats;
+    getAvionics(L)->getCollector().getStats(&stats);
+
+    lua_newtable(L);
+    lua_pushnumber(L, stats.heapSize);
+    lua_setfield(L, -2, "heapSize");
+    lua_pushnumber(L, stats.cycles);
+    lua_setfield(L, -2, "cycles");
+    lua_pushnumber(L, stats.fullCollections);
+    lua_setfield(L, -2, "fullCollections");
+    lua_pushnumber(L, stats.steps);
+    lua_setfield(L, -2, "steps");
+    lua_pushnumber(L, stats.totalTime);
+    lua_setfield(L, -2, "totalTime");
+    lua_pushnumber(L, stats.lastPause);
+    lua_setfield(L, -2, "lastPause");
+    lua_pushnumber(L, stats.maxPause);
+    lua_setfield(L, -2, "maxPause");
+
+    return 1;
+}
+
+
+void xa::exportCollectorToLua(Luna &lua)
+{
+    lua_State *L = lua.getLua();
+
+    lua_register(L, "setGcPolicy", luaSetGcPolicy);
+    lua_register(L, "getGcStats", luaGetGcStats);
+}
+
@@ -0,0 +1,92 @@
+#ifndef __COLLECTOR_H__
+#define __COLLECTOR_H__
+
+
+#include "luna.h"
+#include "rttimer.h"
+
+
+struct SaslGcStats;
+
+
+namespace xa {
+
+/// Runs Lua garbage collector in small steps limited by time budget
+/// instead of unpredictable pauses of default collector
+class Collector
+{
+    private:
+        /// Lua state
+        Luna &lua;
+
+        /// Timer for measurements
+        RtTimer timer;
+
+        /// Maximum time of garbage collection per frame in milliseconds.
+        /// zero if default collector used
+        double budget;
+
+        /// True if garbage collected after draw, false if after update
+        bool afterDraw;
+
+        /// True if garbage collection wasn't run in current frame
+        bool pending;
+
+        /// True if collection cycle is in progress
+        bool collecting;
+
+        /// Heap size in Kb after last finished cycle
+        int lastHeap;
+
+        /// Number of finished collection cycles
+        int cycles;
+
+        /// Number of full collections forced because of heap growth
+        int fullCollections;
+
+        /// Number of incremental steps
+        int steps;
+
+        /// Total time spent on garbage collection in milliseconds
+        double totalTime;
+
+        /// Duration of last garbage collection
+        double lastPause;
+
+        /// Maximum duration of garbage collection
+        double maxPause;
+
+    public:
+        /// Create collector.  Default Lua collector used by default
+        Collector(Luna &lua);
+
+    public:
+        /// Set garbage collection policy
+        /// \param budget maximum time in microseconds spent on garbage 
+        ///     collection each frame.  pass 0 to use default collector.
+        /// \param afterDraw true to collect garbage after draw instead of
+        ///     after update.
+        void setPolicy(int budget, bool afterDraw);
+
+        /// Called after update of each frame
+        void onUpdate();
+
+        /// Called after each draw
+        void onDraw();
+
+        /// Returns collector statistics
+        void getStats(struct SaslGcStats *stats);
+
+    private:
+        /// Run incremental steps until budget exhausted
+        void collect();
+};
+
+
+/// Register garbage collector functions in Lua
+void exportCollectorToLua(Luna &lua);
+
+};
+
+#endif
+
@@ -0,0 +1,188 @@
+#include "fileindex.h"
+
+#include <ctype.h>
+#ifndef WINDOWS
+#include <dirent.h>
+#else
+#include <windows.h>
+#endif
+#include "avionics.h"
+
+
+using namespace xa;
+
+
+#if defined(WINDOWS) || defined(__APPLE__)
+/// file systems are case insensitive by default
+static std::string normalizeName(const std::string &name)
+{
+    std::string s(name);
+    for (std::string::iterator i = s.begin(); i != s.end(); i++)
+        *i = tolower(*i);
+    return s;
+}
+#else
+static const std::string& normalizeName(const std::string &name)
+{
+    return name;
+}
+#endif
+
+
+/// Split path to directory and file name
+static void splitPath(const std::string &path, std::string &dir,
+        std::string &name)
+{
+    std::string::size_type pos = path.find_last_of("/\\");
+    if (std::string::npos == pos) {
+        dir = ".";
+        name = path;
+    } else if (! pos) {
+        dir = path.substr(0, 1);
+        name = path.substr(1);
+    } else {
+        dir = path.substr(0, pos);
+        name = path.substr(pos + 1);
+    }
+}
+
+
+#ifdef WINDOWS
+
+/// Read names of files in directory
+static void readDirectory(const std::string &dir, std::set<std::string> &names)
+{
+    std::string mask = dir + "\\*";
+
+    WIN32_FIND_DATA de;
+    HANDLE handle = FindFirstFile(mask.c_str(), &de);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+
+    do {
+        names.insert(normalizeName(de.cFileName));
+    } while (FindNextFile(handle, &de));
+    FindClose(handle);
+}
+
+#else
+
+/// Read names of files in directory
+static void readDirectory(const std::string &dir, std::set<std::string> &names)
+{
+    DIR *d = opendir(dir.c_str());
+    if (! d)
+        return;
+
+    for (struct dirent *de = readdir(d); de; de = readdir(d))
+        names.insert(normalizeName(de->d_name));
+    closedir(d);
+}
+
+#endif
+
+
+const FileIndex::Names& FileIndex::getNames(const std::string &dir)
+{
+    Directories::iterator i = directories.find(dir);
+    if (i != directories.end())
+        return (*i).second;
+
+    // missing directories stored too, so they are not checked again
+    Names &names = directories[dir];
+    readDirectory(dir, names);
+    return names;
+}
+
+
+bool FileIndex::exists(const std::string &path)
+{
+    std::string dir, name;
+    splitPath(path, dir, name);
+    if (name.empty() || ("." == name) || (".." == name))
+        return false;
+
+    const Names &names = getNames(dir);
+    return names.end() != names.find(normalizeName(name));
+}
+
+
+void FileIndex::invalidate(const std::string &dir)
+{
+    if (dir.empty()) {
+        directories.clear();
+        return;
+    }
+
+    Directories::iterator i = directories.lower_bound(dir);
+    while ((i != directories.end()) && 
+            (! (*i).first.compare(0, dir.size(), dir)))
+    {
+        const std::string &name = (*i).first;
+        if ((name.size() == dir.size()) || ('/' == name[dir.size()]) ||
+                ('\\' == name[dir.size()]))
+            directories.erase(i++);
+        else
+            i++;
+    }
+}
+
+
+
+/// Returns true if file exists
+static int luaFileExists(lua_State *L)
+{
+    const char *path = lua_tostring(L, 1);
+    lua_pushboolean(L, path && getAvionics(L)->getFileIndex().exists(path));
+    return 1;
+}
+
+
+/// Find file in list of directories.  Arguments are array of directories
+/// and file name.  Returns path to first found file or nil
+static int luaFindFile(lua_State *L)
+{
+    const char *fileName = lua_tostring(L, 2);
+    if ((! fileName) || (! lua_istable(L, 1)))
+        return 0;
+
+    FileIndex &index = getAvionics(L)->getFileIndex();
+    std::string path;
+    for (int i = 1; ; i++) {
+        lua_rawgeti(L, 1, i);
+        const char *dir = lua_tostring(L, -1);
+        if (! dir) {
+            lua_pop(L, 1);
+            break;
+        }
+        path = std::string(dir) + "/" + fileName;
+        lua_pop(L, 1);
+        if (index.exists(path)) {
+            lua_pushstring(L, path.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/// Forget cached contents of directory and its subdirectories.
+/// Forget everything if called without arguments
+static int luaInvalidateFileIndex(lua_State *L)
+{
+    const char *dir = lua_tostring(L, 1);
+    getAvionics(L)->getFileIndex().invalidate(dir ? dir : "");
+    return 0;
+}
+
+
+void xa::exportFileIndexToLua(Luna &lua)
+{
+    lua_State *L = lua.getLua();
+
+    lua_register(L, "fileExists", luaFileExists);
+    lua_register(L, "findFile", luaFindFile);
+    lua_register(L, "invalidateFileIndex", luaInvalidateFileIndex);
+}
+
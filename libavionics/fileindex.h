@@ -0,0 +1,47 @@
+#ifndef __FILE_INDEX_H__
+#define __FILE_INDEX_H__
+
+
+#include <string>
+#include <set>
+#include <map>
+#include "luna.h"
+
+
+namespace xa {
+
+/// Cache of directories contents.  Each directory is read once on first
+/// lookup, so checking of many search paths doesn't touch file system
+class FileIndex
+{
+    private:
+        /// Names of files in directory
+        typedef std::set<std::string> Names;
+
+        /// Directories contents mapped by directory path
+        typedef std::map<std::string, Names> Directories;
+
+        /// Directories already read
+        Directories directories;
+
+    public:
+        /// Returns true if file or directory exists
+        bool exists(const std::string &path);
+
+        /// Forget contents of directory and its subdirectories.
+        /// Pass empty string to forget everything
+        void invalidate(const std::string &dir);
+
+    private:
+        /// Returns contents of directory.  Reads it if required
+        const Names& getNames(const std::string &dir);
+};
+
+
+/// Register file index functions in Lua
+void exportFileIndexToLua(Luna &lua);
+
+};
+
+#endif
+
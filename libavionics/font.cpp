@@ -7,6 +7,7 @@
 #include "utils.h"
 #include "unicode.h"
 #include "avionics.h"
+#include "graph.h"
 
 
 
@@ -288,6 +289,13 @@ void xa::drawFont(Font* font, SaslGraphicsCallbacks *graphics, double x, double
 
     double tW = font->texture->getTexture()->getWidth();
     double tH = font->texture->getTexture()->getHeight();
+    int texId = font->texture->getTexture()->getId();
+
+    // glyphs are sent to graphics by chunks
+    const int maxQuads = 64;
+    const int quadSize = 4 * SASL_VERTEX_SIZE;
+    float vertices[maxQuads * quadSize];
+    int quads = 0;
 
     int posX = x;
     for (int i = 0; i < len; i++) {
@@ -303,21 +311,28 @@ void xa::drawFont(Font* font, SaslGraphicsCallbacks *graphics, double x, double
             double gXO = glyph.xOffset;
             double gYO = font->base - (glyph.yOffset + gH);
 
-            graphics->draw_textured_triangle(graphics, 
-                font->texture->getTexture()->getId(),
-                posX + gXO, y + gH + gYO, gX / tW, gY / tH, r, g, b, a,
-                posX + gXO + gW, y + gH + gYO, (gX + gW) / tW, gY / tH, r, g, b, a,
-                posX + gW + gXO, y + gYO, (gX + gW) / tW, (gY + gH) / tH, r, g, b, a);
-            graphics->draw_textured_triangle(graphics, 
-                font->texture->getTexture()->getId(),
-                posX + gW + gXO, y + gYO, (gX + gW) / tW, (gY + gH) / tH, r, g, b, a,
-                posX + gXO, y + gYO, gX / tW, (gY + gH) / tH, r, g, b, a,
-                posX + gXO, y + gH + gYO, gX / tW, gY / tH, r, g, b, a);
+            float *v = vertices + quads * quadSize;
+            setVertex(v, posX + gXO, y + gH + gYO, gX / tW, gY / tH, 
+                    r, g, b, a);
+            setVertex(v + SASL_VERTEX_SIZE, posX + gXO + gW, y + gH + gYO,
+                    (gX + gW) / tW, gY / tH, r, g, b, a);
+            setVertex(v + 2 * SASL_VERTEX_SIZE, posX + gW + gXO, y + gYO,
+                    (gX + gW) / tW, (gY + gH) / tH, r, g, b, a);
+            setVertex(v + 3 * SASL_VERTEX_SIZE, posX + gXO, y + gYO,
+                    gX / tW, (gY + gH) / tH, r, g, b, a);
+            quads++;
+
+            if (maxQuads == quads) {
+                drawQuads(graphics, texId, vertices, quads);
+                quads = 0;
+            }
 
             posX += glyph.xAdvance;
         }
     }
 
+    if (quads)
+        drawQuads(graphics, texId, vertices, quads);
 }
 
 
@@ -9,6 +9,44 @@
 using namespace xa;
 
 
+void xa::drawQuads(SaslGraphicsCallbacks *graphics, int textureId,
+        const float *vertices, int count)
+{
+    if (2 <= graphics->version) {
+        graphics->draw_vertices(graphics, SASL_PRIM_QUADS, textureId,
+                vertices, count * 4);
+        return;
+    }
+
+    const int size = SASL_VERTEX_SIZE;
+    for (int i = 0; i < count; i++) {
+        const float *v1 = vertices + i * 4 * size;
+        const float *v2 = v1 + size;
+        const float *v3 = v2 + size;
+        const float *v4 = v3 + size;
+        if (-1 == textureId) {
+            graphics->draw_triangle(graphics,
+                    v1[0], v1[1], v1[4], v1[5], v1[6], v1[7],
+                    v2[0], v2[1], v2[4], v2[5], v2[6], v2[7],
+                    v3[0], v3[1], v3[4], v3[5], v3[6], v3[7]);
+            graphics->draw_triangle(graphics,
+                    v1[0], v1[1], v1[4], v1[5], v1[6], v1[7],
+                    v3[0], v3[1], v3[4], v3[5], v3[6], v3[7],
+                    v4[0], v4[1], v4[4], v4[5], v4[6], v4[7]);
+        } else {
+            graphics->draw_textured_triangle(graphics, textureId,
+                    v1[0], v1[1], v1[2], v1[3], v1[4], v1[5], v1[6], v1[7],
+                    v2[0], v2[1], v2[2], v2[3], v2[4], v2[5], v2[6], v2[7],
+                    v3[0], v3[1], v3[2], v3[3], v3[4], v3[5], v3[6], v3[7]);
+            graphics->draw_textured_triangle(graphics, textureId,
+                    v1[0], v1[1], v1[2], v1[3], v1[4], v1[5], v1[6], v1[7],
+                    v3[0], v3[1], v3[2], v3[3], v3[4], v3[5], v3[6], v3[7],
+                    v4[0], v4[1], v4[2], v4[3], v4[4], v4[5], v4[6], v4[7]);
+        }
+    }
+}
+
+
 static void setupMatrix(Avionics *avionics, double x, double y,
         double width, double height,
         double originalWidth, double originalHeight)
@@ -89,14 +127,12 @@ static void drawRectangle(Avionics *avionics, double x, double y,
     SaslGraphicsCallbacks *graphics = avionics->getGraphics();
     assert(graphics);
 
-    graphics->draw_triangle(graphics,
-            x, y + height, r, g, b, a,
-            x + width, y + height, r, g, b, a,
-            x + width, y, r, g, b, a);
-    graphics->draw_triangle(graphics,
-            x, y + height, r, g, b, a,
-            x + width, y, r, g, b, a,
-            x, y, r, g, b, a);
+    float v[4 * SASL_VERTEX_SIZE];
+    setVertex(v, x, y + height, 0, 0, r, g, b, a);
+    setVertex(v + SASL_VERTEX_SIZE, x + width, y + height, 0, 0, r, g, b, a);
+    setVertex(v + 2 * SASL_VERTEX_SIZE, x + width, y, 0, 0, r, g, b, a);
+    setVertex(v + 3 * SASL_VERTEX_SIZE, x, y, 0, 0, r, g, b, a);
+    drawQuads(graphics, -1, v, 1);
 }
 
 /// Lua wrapper for drawRectangle
@@ -160,14 +196,15 @@ static void drawTexture(Avionics *avionics, TexturePart *tex,
     SaslGraphicsCallbacks *graphics = avionics->getGraphics();
     assert(graphics);
 
-    graphics->draw_textured_triangle(graphics, tex->getTexture()->getId(),
-            x, y + height, tex->getX1(), tex->getY1(), r, g, b, a,
-            x + width, y + height, tex->getX2(), tex->getY1(), r, g, b, a,
-            x + width, y, tex->getX2(), tex->getY2(), r, g, b, a);
-    graphics->draw_textured_triangle(graphics, tex->getTexture()->getId(),
-            x, y + height, tex->getX1(), tex->getY1(), r, g, b, a,
-            x + width, y, tex->getX2(), tex->getY2(), r, g, b, a,
-            x, y, tex->getX1(), tex->getY2(), r, g, b, a);
+    float v[4 * SASL_VERTEX_SIZE];
+    setVertex(v, x, y + height, tex->getX1(), tex->getY1(), r, g, b, a);
+    setVertex(v + SASL_VERTEX_SIZE, x + width, y + height,
+            tex->getX2(), tex->getY1(), r, g, b, a);
+    setVertex(v + 2 * SASL_VERTEX_SIZE, x + width, y,
+            tex->getX2(), tex->getY2(), r, g, b, a);
+    setVertex(v + 3 * SASL_VERTEX_SIZE, x, y,
+            tex->getX1(), tex->getY2(), r, g, b, a);
+    drawQuads(graphics, tex->getTexture()->getId(), v, 1);
 }
 
 
@@ -224,14 +261,13 @@ static void drawTexturePart(Avionics *avionics, TexturePart *tex,
     double tx2 = tx1 + pw * tw;
     double ty2 = ty1 + ph * th;
 
-    graphics->draw_textured_triangle(graphics, tex->getTexture()->getId(),
-            x, y + height, tx1, ty1, r, g, b, a,
-            x + width, y + height, tx2, ty1, r, g, b, a,
-            x + width, y, tx2, ty2, r, g, b, a);
-    graphics->draw_textured_triangle(graphics, tex->getTexture()->getId(),
-            x, y + height, tx1, ty1, r, g, b, a,
-            x + width, y, tx2, ty2, r, g, b, a,
-            x, y, tx1, ty2, r, g, b, a);
+    float v[4 * SASL_VERTEX_SIZE];
+    setVertex(v, x, y + height, tx1, ty1, r, g, b, a);
+    setVertex(v + SASL_VERTEX_SIZE, x + width, y + height, tx2, ty1,
+            r, g, b, a);
+    setVertex(v + 2 * SASL_VERTEX_SIZE, x + width, y, tx2, ty2, r, g, b, a);
+    setVertex(v + 3 * SASL_VERTEX_SIZE, x, y, tx1, ty2, r, g, b, a);
+    drawQuads(graphics, tex->getTexture()->getId(), v, 1);
 }
 
 
@@ -414,14 +450,13 @@ static void drawIntricatelyTexturedRectangle(Avionics *avionics,
     double c4x, c4y;
     rotatePoint(c4x, c4y, tx1, ty2, tcx, tcy, angle, tex);
 
-    graphics->draw_textured_triangle(graphics, tex->getTexture()->getId(),
-            x, y + height, c1x, c1y, r, g, b, a,
-            x + width, y + height, c2x, c2y, r, g, b, a,
-            x + width, y, c3x, c3y, r, g, b, a);
-    graphics->draw_textured_triangle(graphics, tex->getTexture()->getId(),
-            x, y + height, c1x, c1y, r, g, b, a,
-            x + width, y, c3x, c3y, r, g, b, a,
-            x, y, c4x, c4y, r, g, b, a);
+    float v[4 * SASL_VERTEX_SIZE];
+    setVertex(v, x, y + height, c1x, c1y, r, g, b, a);
+    setVertex(v + SASL_VERTEX_SIZE, x + width, y + height, c2x, c2y,
+            r, g, b, a);
+    setVertex(v + 2 * SASL_VERTEX_SIZE, x + width, y, c3x, c3y, r, g, b, a);
+    setVertex(v + 3 * SASL_VERTEX_SIZE, x, y, c4x, c4y, r, g, b, a);
+    drawQuads(graphics, tex->getTexture()->getId(), v, 1);
 }
 
 
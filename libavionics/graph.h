@@ -15,6 +15,31 @@ namespace xa {
 void exportGraphToLua(Luna &lua);
 
 
+/// Fill vertex of batch passed to drawQuads
+inline void setVertex(float *vertex, double x, double y, double u, double v,
+        double r, double g, double b, double a)
+{
+    vertex[0] = x;
+    vertex[1] = y;
+    vertex[2] = u;
+    vertex[3] = v;
+    vertex[4] = r;
+    vertex[5] = g;
+    vertex[6] = b;
+    vertex[7] = a;
+}
+
+/// Draw quads.  Uses batched drawing if graphics supports it and
+/// falls back to pairs of triangles otherwise.
+/// \param graphics graphics callbacks.
+/// \param textureId texture ID or -1 for untextured quads.
+/// \param vertices 4 vertices of SASL_VERTEX_SIZE floats for each quad
+///     starting from top left corner.
+/// \param count number of quads.
+void drawQuads(SaslGraphicsCallbacks *graphics, int textureId,
+        const float *vertices, int count);
+
+
 };
 
 #endif
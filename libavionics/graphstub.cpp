@@ -126,11 +126,56 @@ static void recreateTexture(struct SaslGraphicsCallbacks *canvas,
 }
 
 
+// draw batch of primitives
+static void drawVertices(struct SaslGraphicsCallbacks *canvas, 
+        int mode, int textureId, const float *vertices, int count)
+{
+}
+
+
+// create texture for render target
+static int createTexture(struct SaslGraphicsCallbacks *canvas, 
+        int width, int height)
+{
+    return -1;
+}
+
+
+// fill current render target with color
+static void clearRenderTarget(struct SaslGraphicsCallbacks *canvas, 
+        double r, double g, double b, double a)
+{
+}
+
+
+// returns number of primitives drawn
+static void getStatistics(struct SaslGraphicsCallbacks *canvas, 
+        int *triangles, int *lines, int *batches)
+{
+    if (triangles)
+        *triangles = 0;
+    if (lines)
+        *lines = 0;
+    if (batches)
+        *batches = 0;
+}
+
+
+// create texture from decoded image
+static int loadTexturePixels(struct SaslGraphicsCallbacks *canvas,
+        const unsigned char *pixels, int imageWidth, int imageHeight, 
+        int channels, int *width, int *height)
+{
+    return -1;
+}
+
+
 static struct SaslGraphicsCallbacks callbacks = { drawBegin, drawEnd,
     loadTexture, freeTexture, drawLine, drawTriangle, drawTexturedTriangle,
     setClipArea, resetClipArea, pushTransform, popTransform, 
     translateTransform, scaleTransform, rotateTransform, findTexture,
-    setRenderTarget, recreateTexture };
+    setRenderTarget, recreateTexture, SASL_GRAPHICS_VERSION, drawVertices,
+    createTexture, clearRenderTarget, getStatistics, loadTexturePixels };
 
 
 SaslGraphicsCallbacks* xa::getGraphicsStub()
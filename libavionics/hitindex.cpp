@@ -0,0 +1,226 @@
+#include "hitindex.h"
+
+#include <math.h>
+#include <new>
+
+
+using namespace xa;
+
+
+/// Maximum number of grid columns and rows
+#define MAX_GRID_SIZE 32
+
+/// Name of Lua metatable of hit index objects
+#define HIT_INDEX_META "xa.HitIndex"
+
+
+
+HitIndex::HitIndex()
+{
+    cols = rows = 0;
+    minX = minY = 0;
+    cellWidth = cellHeight = 1;
+    built = true;
+}
+
+
+void HitIndex::clear()
+{
+    rects.clear();
+    for (std::vector< std::vector<int> >::iterator i = cells.begin();
+            i != cells.end(); i++)
+        (*i).clear();
+    cols = rows = 0;
+    built = true;
+}
+
+
+void HitIndex::add(int id, float x, float y, float width, float height)
+{
+    if ((0 >= width) || (0 >= height))
+        return;
+
+    Rect r;
+    r.id = id;
+    r.x1 = x;
+    r.y1 = y;
+    r.x2 = x + width;
+    r.y2 = y + height;
+    rects.push_back(r);
+    built = false;
+}
+
+
+int HitIndex::getCol(float x) const
+{
+    int col = (int)((x - minX) / cellWidth);
+    if (0 > col)
+        return 0;
+    if (col >= cols)
+        return cols - 1;
+    return col;
+}
+
+
+int HitIndex::getRow(float y) const
+{
+    int row = (int)((y - minY) / cellHeight);
+    if (0 > row)
+        return 0;
+    if (row >= rows)
+        return rows - 1;
+    return row;
+}
+
+
+void HitIndex::build()
+{
+    built = true;
+    cols = rows = 0;
+    if (rects.empty())
+        return;
+
+    float maxX = rects[0].x2;
+    float maxY = rects[0].y2;
+    minX = rects[0].x1;
+    minY = rects[0].y1;
+    for (std::vector<Rect>::const_iterator i = rects.begin();
+            i != rects.end(); i++)
+    {
+        const Rect &r = *i;
+        if (r.x1 < minX) minX = r.x1;
+        if (r.y1 < minY) minY = r.y1;
+        if (r.x2 > maxX) maxX = r.x2;
+        if (r.y2 > maxY) maxY = r.y2;
+    }
+
+    // about one rectangle per cell for evenly distributed rectangles
+    int size = (int)ceil(sqrt((double)rects.size()));
+    if (MAX_GRID_SIZE < size)
+        size = MAX_GRID_SIZE;
+    cols = rows = size;
+    cellWidth = (maxX - minX) / cols;
+    cellHeight = (maxY - minY) / rows;
+
+    if ((int)cells.size() < cols * rows)
+        cells.resize(cols * rows);
+    for (int i = 0; i < cols * rows; i++)
+        cells[i].clear();
+
+    for (int i = 0; i < (int)rects.size(); i++) {
+        const Rect &r = rects[i];
+        int col1 = getCol(r.x1);
+        int col2 = getCol(r.x2);
+        int row1 = getRow(r.y1);
+        int row2 = getRow(r.y2);
+        for (int row = row1; row <= row2; row++)
+            for (int col = col1; col <= col2; col++)
+                cells[row * cols + col].push_back(i);
+    }
+}
+
+
+int HitIndex::find(float x, float y, std::vector<int> &ids)
+{
+    ids.clear();
+
+    if (! built)
+        build();
+    if ((! cols) || (x < minX) || (y < minY) ||
+            (x >= minX + cellWidth * cols) || (y >= minY + cellHeight * rows))
+        return 0;
+
+    // cells store rectangles in order of addition
+    const std::vector<int> &cell = cells[getRow(y) * cols + getCol(x)];
+    for (std::vector<int>::const_reverse_iterator i = cell.rbegin();
+            i != cell.rend(); i++)
+    {
+        const Rect &r = rects[*i];
+        if ((r.x1 <= x) && (r.x2 > x) && (r.y1 <= y) && (r.y2 > y))
+            ids.push_back(r.id);
+    }
+
+    return ids.size();
+}
+
+
+
+/// Returns hit index stored in Lua stack
+static HitIndex* getHitIndex(lua_State *L, int idx)
+{
+    return (HitIndex*)luaL_checkudata(L, idx, HIT_INDEX_META);
+}
+
+
+/// Create new hit index
+static int luaCreateHitIndex(lua_State *L)
+{
+    void *data = lua_newuserdata(L, sizeof(HitIndex));
+    new (data) HitIndex();
+    luaL_getmetatable(L, HIT_INDEX_META);
+    lua_setmetatable(L, -2);
+    return 1;
+}
+
+
+/// Destroy hit index collected by Lua
+static int luaDestroyHitIndex(lua_State *L)
+{
+    HitIndex *index = getHitIndex(L, 1);
+    index->~HitIndex();
+    return 0;
+}
+
+
+/// Remove all rectangles from hit index
+static int luaHitIndexClear(lua_State *L)
+{
+    getHitIndex(L, 1)->clear();
+    return 0;
+}
+
+
+/// Add rectangle to hit index
+static int luaHitIndexAdd(lua_State *L)
+{
+    getHitIndex(L, 1)->add((int)lua_tonumber(L, 2), lua_tonumber(L, 3),
+            lua_tonumber(L, 4), lua_tonumber(L, 5), lua_tonumber(L, 6));
+    return 0;
+}
+
+
+/// Store IDs of rectangles under point into table passed as 4th argument.
+/// Returns number of IDs found
+static int luaHitIndexFind(lua_State *L)
+{
+    static std::vector<int> ids;
+
+    HitIndex *index = getHitIndex(L, 1);
+    int count = index->find(lua_tonumber(L, 2), lua_tonumber(L, 3), ids);
+
+    if (lua_istable(L, 4))
+        for (int i = 0; i < count; i++) {
+            lua_pushnumber(L, ids[i]);
+            lua_rawseti(L, 4, i + 1);
+        }
+
+    lua_pushnumber(L, count);
+    return 1;
+}
+
+
+void xa::exportHitIndexToLua(Luna &lua)
+{
+    lua_State *L = lua.getLua();
+
+    luaL_newmetatable(L, HIT_INDEX_META);
+    lua_pushcfunction(L, luaDestroyHitIndex);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    lua_register(L, "createHitIndex", luaCreateHitIndex);
+    lua_register(L, "hitIndexClear", luaHitIndexClear);
+    lua_register(L, "hitIndexAdd", luaHitIndexAdd);
+    lua_register(L, "hitIndexFind", luaHitIndexFind);
+}
+
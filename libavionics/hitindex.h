@@ -0,0 +1,89 @@
+#ifndef __HIT_INDEX_H__
+#define __HIT_INDEX_H__
+
+
+#include <vector>
+#include "luna.h"
+
+
+namespace xa {
+
+/// Uniform grid of rectangles used to find components under mouse
+/// without checking all of them
+class HitIndex
+{
+    private:
+        /// Rectangle stored in index
+        struct Rect
+        {
+            /// ID of rectangle
+            int id;
+
+            /// Bottom left corner
+            float x1, y1;
+
+            /// Top right corner
+            float x2, y2;
+        };
+
+        /// All rectangles in order of addition
+        std::vector<Rect> rects;
+
+        /// Indices of rectangles crossing each grid cell
+        std::vector< std::vector<int> > cells;
+
+        /// Number of columns of grid
+        int cols;
+
+        /// Number of rows of grid
+        int rows;
+
+        /// Bottom left corner of grid
+        float minX, minY;
+
+        /// Size of grid cell
+        float cellWidth, cellHeight;
+
+        /// True if grid matches rectangles list
+        bool built;
+
+    public:
+        /// Create empty index
+        HitIndex();
+
+    public:
+        /// Remove all rectangles
+        void clear();
+
+        /// Add rectangle to index.  Rectangles added later are considered
+        /// to be above rectangles added before
+        /// \param id rectangle ID.
+        /// \param x X coord of bottom left corner.
+        /// \param y Y coord of bottom left corner.
+        /// \param width width of rectangle.
+        /// \param height height of rectangle.
+        void add(int id, float x, float y, float width, float height);
+
+        /// Find rectangles containing point.  IDs are ordered from topmost
+        /// rectangle.  Returns number of IDs found.
+        int find(float x, float y, std::vector<int> &ids);
+
+    private:
+        /// Distribute rectangles to grid cells
+        void build();
+
+        /// Returns column of grid containing X coord
+        int getCol(float x) const;
+
+        /// Returns row of grid containing Y coord
+        int getRow(float y) const;
+};
+
+
+/// Register hit index functions in Lua
+void exportHitIndexToLua(Luna &lua);
+
+};
+
+#endif
+
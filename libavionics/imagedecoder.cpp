@@ -0,0 +1,178 @@
+#include "imagedecoder.h"
+
+#include <stdlib.h>
+#include "SOIL.h"
+
+
+using namespace xa;
+
+
+ImageDecoder::ImageDecoder(): generation(0), stopping(false)
+{
+}
+
+
+ImageDecoder::~ImageDecoder()
+{
+    stopWorkers();
+    cancel();
+}
+
+
+void ImageDecoder::startWorkers()
+{
+    int count = Thread::getProcessorsCount() - 1;
+    if (count > MAX_WORKERS)
+        count = MAX_WORKERS;
+    if (1 > count)
+        count = 1;
+
+    for (int i = 0; i < count; i++) {
+        Thread *thread = new Thread();
+        if (! thread->start(work, this)) {
+            delete thread;
+            break;
+        }
+        workers.push_back(thread);
+    }
+}
+
+
+void ImageDecoder::stopWorkers()
+{
+    {
+        MutexLock lock(mutex);
+        stopping = true;
+        queued.broadcast();
+    }
+
+    for (std::vector<Thread*>::iterator i = workers.begin(); 
+            i != workers.end(); i++)
+        delete *i;
+    workers.clear();
+}
+
+
+void ImageDecoder::request(const std::string &fileName)
+{
+    MutexLock lock(mutex);
+
+    if (images.count(fileName) || decoding.count(fileName))
+        return;
+    for (std::list<std::string>::iterator i = queue.begin(); 
+            i != queue.end(); i++)
+        if (*i == fileName)
+            return;
+
+    if (workers.empty())
+        startWorkers();
+
+    queue.push_back(fileName);
+    queued.signal();
+}
+
+
+bool ImageDecoder::take(const std::string &fileName, DecodedImage &image)
+{
+    mutex.lock();
+
+    while (decoding.count(fileName))
+        decoded.wait(mutex);
+
+    Images::iterator i = images.find(fileName);
+    if (i != images.end()) {
+        image = (*i).second;
+        images.erase(i);
+        mutex.unlock();
+        return true;
+    }
+
+    // not started yet, it is faster to decode it here than to wait
+    for (std::list<std::string>::iterator j = queue.begin(); 
+            j != queue.end(); j++)
+    {
+        if (*j == fileName) {
+            queue.erase(j);
+            mutex.unlock();
+            decode(fileName, image);
+            return true;
+        }
+    }
+
+    mutex.unlock();
+    return false;
+}
+
+
+void ImageDecoder::cancel()
+{
+    MutexLock lock(mutex);
+
+    generation++;
+    queue.clear();
+    for (Images::iterator i = images.begin(); i != images.end(); i++)
+        freeImage((*i).second);
+    images.clear();
+}
+
+
+int ImageDecoder::getPending()
+{
+    MutexLock lock(mutex);
+    return queue.size() + decoding.size() + images.size();
+}
+
+
+void ImageDecoder::freeImage(DecodedImage &image)
+{
+    if (image.pixels)
+        SOIL_free_image_data(image.pixels);
+    image.pixels = NULL;
+}
+
+
+void ImageDecoder::work(void *decoder)
+{
+    ((ImageDecoder*)decoder)->run();
+}
+
+
+void ImageDecoder::run()
+{
+    mutex.lock();
+
+    while (! stopping) {
+        if (queue.empty()) {
+            queued.wait(mutex);
+            continue;
+        }
+
+        std::string fileName = queue.front();
+        queue.pop_front();
+        decoding.insert(fileName);
+        int jobGeneration = generation;
+        mutex.unlock();
+
+        DecodedImage image;
+        decode(fileName, image);
+
+        mutex.lock();
+        decoding.erase(fileName);
+        if (jobGeneration == generation)
+            images[fileName] = image;
+        else
+            freeImage(image);
+        decoded.broadcast();
+    }
+
+    mutex.unlock();
+}
+
+
+void ImageDecoder::decode(const std::string &fileName, DecodedImage &image)
+{
+    image.width = image.height = image.channels = 0;
+    image.pixels = SOIL_load_image(fileName.c_str(), &image.width, 
+            &image.height, &image.channels, SOIL_LOAD_AUTO);
+}
+
@@ -0,0 +1,116 @@
+#ifndef __IMAGE_DECODER_H__
+#define __IMAGE_DECODER_H__
+
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "thread.h"
+
+
+namespace xa {
+
+
+/// Image pixels decoded from file
+struct DecodedImage
+{
+    /// Image pixels or NULL if image can't be decoded
+    unsigned char *pixels;
+
+    /// Width of image in pixels
+    int width;
+
+    /// Height of image in pixels
+    int height;
+
+    /// Number of bytes per pixel
+    int channels;
+};
+
+
+/// Decodes image files on pool of worker threads.
+/// It only produces pixels, textures should be created by caller
+/// in graphics thread
+class ImageDecoder
+{
+    private:
+        /// Decoded images mapped by file name
+        typedef std::map<std::string, DecodedImage> Images;
+
+        /// Maximum number of worker threads
+        static const int MAX_WORKERS = 8;
+
+        /// Guards all fields below
+        Mutex mutex;
+
+        /// Signaled when new files are queued or decoder stops
+        Condition queued;
+
+        /// Signaled when file is decoded
+        Condition decoded;
+
+        /// Files waiting for decoding
+        std::list<std::string> queue;
+
+        /// Files being decoded by worker threads
+        std::set<std::string> decoding;
+
+        /// Decoded images not taken yet
+        Images images;
+
+        /// Worker threads
+        std::vector<Thread*> workers;
+
+        /// Incremented on cancel so results of cancelled jobs are dropped
+        int generation;
+
+        /// True if workers should exit
+        bool stopping;
+
+    public:
+        ImageDecoder();
+
+        /// Stop worker threads and free decoded images
+        ~ImageDecoder();
+
+    public:
+        /// Queue file for decoding.  Workers are started on first request
+        void request(const std::string &fileName);
+
+        /// Get decoded image.  Waits for decoding if file is queued or
+        /// being decoded.  Returns false if file wasn't requested.
+        /// Caller should free image pixels using freeImage
+        bool take(const std::string &fileName, DecodedImage &image);
+
+        /// Forget all queued files and images not taken yet
+        void cancel();
+
+        /// Returns number of queued and decoded but not taken images
+        int getPending();
+
+        /// Free image pixels
+        static void freeImage(DecodedImage &image);
+
+    private:
+        /// Start worker threads
+        void startWorkers();
+
+        /// Stop worker threads
+        void stopWorkers();
+
+        /// Worker thread function
+        static void work(void *decoder);
+
+        /// Decode queued files until decoder stops
+        void run();
+
+        /// Read and decode image file
+        static void decode(const std::string &fileName, DecodedImage &image);
+};
+
+};
+
+#endif
+
@@ -97,6 +97,43 @@ typedef int (*sasl_update_props_callback)(SaslProps props);
 /// Destroy properties.
 typedef void (*sasl_props_done)(SaslProps props);
 
+/// Read elements of array property starting from offset.
+/// Index of property reference is ignored, offset counts from start
+/// of array.  Scalar properties are treated as arrays of single element.
+/// Returns number of elements read or -1 on error
+typedef int (*sasl_get_prop_array_int_callback)(SaslPropRef prop, 
+        int offset, int count, int *values);
+
+/// Write elements of array property starting from offset.
+/// Returns zero on success or non-zero on error
+typedef int (*sasl_set_prop_array_int_callback)(SaslPropRef prop, 
+        int offset, int count, const int *values);
+
+/// Read elements of array property as floats.
+/// Returns number of elements read or -1 on error
+typedef int (*sasl_get_prop_array_float_callback)(SaslPropRef prop, 
+        int offset, int count, float *values);
+
+/// Write elements of array property as floats.
+/// Returns zero on success or non-zero on error
+typedef int (*sasl_set_prop_array_float_callback)(SaslPropRef prop, 
+        int offset, int count, const float *values);
+
+/// Read values of several properties as doubles at once.
+/// Values of properties which can't be read are set to zero.
+/// Returns number of properties failed to read
+typedef int (*sasl_get_props_double_callback)(const SaslPropRef *props, 
+        int count, double *values);
+
+/// Ask remote properties source to send changes of property without
+/// requests.  Returns zero on success or non-zero if not supported
+/// \param prop property reference.
+/// \param rate maximum number of updates per second.  0 disables push.
+/// \param deadband minimum change of value to send.
+/// \param relative if non-zero deadband is fraction of last sent value.
+typedef int (*sasl_set_prop_push_callback)(SaslPropRef prop, double rate,
+        double deadband, int relative);
+
 /// All callbacks for handy setup
 struct SaslPropsCallbacks {
     sasl_get_prop_ref_callback get_prop_ref;
@@ -113,6 +150,18 @@ struct SaslPropsCallbacks {
     sasl_set_prop_string_callback set_prop_string;
     sasl_update_props_callback update_props;
     sasl_props_done props_done;
+
+    // array access.  could be NULL if not supported
+    sasl_get_prop_array_int_callback get_prop_array_int;
+    sasl_set_prop_array_int_callback set_prop_array_int;
+    sasl_get_prop_array_float_callback get_prop_array_float;
+    sasl_set_prop_array_float_callback set_prop_array_float;
+
+    // batched access.  could be NULL if not supported
+    sasl_get_props_double_callback get_props_double;
+
+    // push updates of networked properties.  could be NULL if not supported
+    sasl_set_prop_push_callback set_prop_push;
 };
 
 
@@ -251,6 +300,55 @@ typedef void (*sasl_recreate_texture)(struct SaslGraphicsCallbacks *canvas,
         int textureId, int width, int height);
 
 
+/// version of graphics callbacks structure
+#define SASL_GRAPHICS_VERSION 5
+
+/// primitives for draw_vertices: each 3 vertices form triangle
+#define SASL_PRIM_TRIANGLES 1
+
+/// primitives for draw_vertices: each 2 vertices form line
+#define SASL_PRIM_LINES 2
+
+/// primitives for draw_vertices: each 4 vertices form quad (drawn as two
+/// triangles: 1, 2, 3 and 1, 3, 4)
+#define SASL_PRIM_QUADS 3
+
+/// number of floats per vertex for draw_vertices: x, y, u, v, r, g, b, a
+#define SASL_VERTEX_SIZE 8
+
+// draw batch of primitives (version 2).
+// vertices contains count * SASL_VERTEX_SIZE floats
+// pass -1 as texture ID to draw untextured primitives
+typedef void (*sasl_draw_vertices)(struct SaslGraphicsCallbacks *canvas, 
+        int mode, int textureId, const float *vertices, int count);
+
+// create new empty texture of specified size suitable for render target
+// (version 3).  texture stores colors premultiplied by alpha and its
+// rows go from bottom to top.
+// returns texture id or -1 if render targets are not supported
+typedef int (*sasl_create_texture)(struct SaslGraphicsCallbacks *canvas, 
+        int width, int height);
+
+// fill current render target with specified color (version 3).
+// does nothing if there is no render target set
+typedef void (*sasl_clear_render_target)(struct SaslGraphicsCallbacks *canvas, 
+        double r, double g, double b, double a);
+
+// returns number of primitives and batches drawn since draw_begin
+// (version 4).  pass NULL to skip value
+typedef void (*sasl_get_statistics)(struct SaslGraphicsCallbacks *canvas, 
+        int *triangles, int *lines, int *batches);
+
+// create texture from decoded image (version 5).
+// pixels contains imageWidth * imageHeight * channels bytes, rows
+// stored from top to bottom.
+// Returns texture ID or -1 on failure.  On success returns texture width
+// and height in pixels
+typedef int (*sasl_load_texture_pixels)(struct SaslGraphicsCallbacks *canvas,
+        const unsigned char *pixels, int imageWidth, int imageHeight, 
+        int channels, int *width, int *height);
+
+
 // grpahics callbacks
 struct SaslGraphicsCallbacks {
     sasl_draw_begin draw_begin;
@@ -270,6 +368,21 @@ struct SaslGraphicsCallbacks {
     sasl_find_texture find_texture;
     sasl_set_render_target set_render_target;
     sasl_recreate_texture recreate_texture;
+
+    // version 2 callbacks.  fields below are used only if version is
+    // SASL_GRAPHICS_VERSION or greater
+    int version;
+    sasl_draw_vertices draw_vertices;
+
+    // version 3 callbacks
+    sasl_create_texture create_texture;
+    sasl_clear_render_target clear_render_target;
+
+    // version 4 callbacks
+    sasl_get_statistics get_statistics;
+
+    // version 5 callbacks
+    sasl_load_texture_pixels load_texture_pixels;
 };
 
 
@@ -270,6 +270,46 @@ int sasl_set_prop_double(SASL sasl, SaslPropRef ref, double value)
     return -1;
 }
 
+int sasl_get_prop_array_int(SASL sasl, SaslPropRef ref, int offset, 
+        int count, int *values)
+{
+    TRY
+        return sasl->avionics->getProps().getPropArray(ref, offset, count, 
+                values);
+    CATCH("getting int array property value")
+    return -1;
+}
+
+int sasl_set_prop_array_int(SASL sasl, SaslPropRef ref, int offset, 
+        int count, const int *values)
+{
+    TRY
+        return sasl->avionics->getProps().setPropArray(ref, offset, count, 
+                values);
+    CATCH("setting int array property value")
+    return -1;
+}
+
+int sasl_get_prop_array_float(SASL sasl, SaslPropRef ref, int offset, 
+        int count, float *values)
+{
+    TRY
+        return sasl->avionics->getProps().getPropArray(ref, offset, count, 
+                values);
+    CATCH("getting float array property value")
+    return -1;
+}
+
+int sasl_set_prop_array_float(SASL sasl, SaslPropRef ref, int offset, 
+        int count, const float *values)
+{
+    TRY
+        return sasl->avionics->getProps().setPropArray(ref, offset, count, 
+                values);
+    CATCH("setting float array property value")
+    return -1;
+}
+
 
 int sasl_set_background_color(SASL sasl, float r, float g, float b, float a)
 {
@@ -616,3 +656,63 @@ void* sasl_import_texture(SASL sasl, int id)
     return sasl->avionics->getTextureManager()->addForeignTexture(id);
 }
 
+
+void sasl_enable_profiler(SASL sasl, int enable, int logPeriod)
+{
+    assert(sasl && sasl->avionics);
+    sasl->avionics->getProfiler().setEnabled(enable, logPeriod);
+}
+
+int sasl_get_profile(SASL sasl, struct SaslProfileEntry *entries, 
+        int maxEntries, int *frames)
+{
+    assert(sasl && sasl->avionics);
+    return sasl->avionics->getProfiler().getProfile(entries, maxEntries, 
+            frames);
+}
+
+void sasl_reset_profile(SASL sasl)
+{
+    assert(sasl && sasl->avionics);
+    sasl->avionics->getProfiler().reset();
+}
+
+void sasl_set_gc_policy(SASL sasl, int budget, int afterDraw)
+{
+    assert(sasl && sasl->avionics);
+    sasl->avionics->getCollector().setPolicy(budget, afterDraw);
+}
+
+void sasl_get_gc_stats(SASL sasl, struct SaslGcStats *stats)
+{
+    assert(sasl && sasl->avionics);
+    sasl->avionics->getCollector().getStats(stats);
+}
+
+void sasl_enable_props_stats(SASL sasl, int enable)
+{
+    assert(sasl && sasl->avionics);
+    sasl->avionics->getProps().getStats().setEnabled(enable);
+}
+
+int sasl_get_props_stats(SASL sasl, struct SaslPropStats *stats, 
+        int maxStats)
+{
+    assert(sasl && sasl->avionics);
+    return sasl->avionics->getProps().getStats().getStats(stats, maxStats);
+}
+
+void sasl_reset_props_stats(SASL sasl)
+{
+    assert(sasl && sasl->avionics);
+    sasl->avionics->getProps().getStats().reset();
+}
+
+int sasl_dump_props_stats(SASL sasl, const char *fileName)
+{
+    assert(sasl && sasl->avionics);
+    if (! fileName)
+        return -1;
+    return sasl->avionics->getProps().getStats().dump(fileName);
+}
+
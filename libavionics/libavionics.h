@@ -206,6 +206,50 @@ double sasl_get_prop_double(SASL sasl, SaslPropRef ref, int *err);
 int sasl_set_prop_double(SASL sasl, SaslPropRef ref, double value);
 
 
+/// Read elements of array property as integers.
+/// Returns number of elements read or -1 on error
+/// \param sasl SASL handler.
+/// \param ref reference to property.
+/// \param offset index of first element to read.
+/// \param count number of elements to read.
+/// \param values buffer for at least count elements.
+int sasl_get_prop_array_int(SASL sasl, SaslPropRef ref, int offset, 
+        int count, int *values);
+
+
+/// Write elements of array property as integers.
+/// Returns 0 on success
+/// \param sasl SASL handler.
+/// \param ref reference to property.
+/// \param offset index of first element to write.
+/// \param count number of elements to write.
+/// \param values new values of elements.
+int sasl_set_prop_array_int(SASL sasl, SaslPropRef ref, int offset, 
+        int count, const int *values);
+
+
+/// Read elements of array property as floats.
+/// Returns number of elements read or -1 on error
+/// \param sasl SASL handler.
+/// \param ref reference to property.
+/// \param offset index of first element to read.
+/// \param count number of elements to read.
+/// \param values buffer for at least count elements.
+int sasl_get_prop_array_float(SASL sasl, SaslPropRef ref, int offset, 
+        int count, float *values);
+
+
+/// Write elements of array property as floats.
+/// Returns 0 on success
+/// \param sasl SASL handler.
+/// \param ref reference to property.
+/// \param offset index of first element to write.
+/// \param count number of elements to write.
+/// \param values new values of elements.
+int sasl_set_prop_array_float(SASL sasl, SaslPropRef ref, int offset, 
+        int count, const float *values);
+
+
 /// Set color of texture background
 /// \param sasl SASL handler.
 /// \param r color red component
@@ -451,6 +495,160 @@ void* sasl_import_texture(SASL sasl, int id);
 
 
 
+// Profiler API
+
+
+/// Time spent by single component.  Times are in milliseconds summed over
+/// all measured frames
+struct SaslProfileEntry {
+    /// name of component
+    const char *name;
+
+    /// number of update calls
+    int updateCalls;
+
+    /// time spent in update including subcomponents
+    double updateTime;
+
+    /// time spent in update excluding subcomponents
+    double updateSelfTime;
+
+    /// number of draw calls
+    int drawCalls;
+
+    /// time spent in draw including subcomponents
+    double drawTime;
+
+    /// time spent in draw excluding subcomponents
+    double drawSelfTime;
+
+    /// triangles drawn by component excluding subcomponents
+    int triangles;
+
+    /// batches flushed while component was drawn excluding subcomponents
+    int batches;
+};
+
+/// Enable or disable per-component profiler.  Components are not measured
+/// while profiler is disabled
+/// \param sasl SASL handler.
+/// \param enable non-zero to enable profiler.
+/// \param logPeriod number of seconds between profile dumps to log.
+///     Statistics is reset after each dump.  Pass 0 to disable dumps.
+void sasl_enable_profiler(SASL sasl, int enable, int logPeriod);
+
+/// Copy collected statistics into buffer.
+/// Returns number of available entries which may be greater than maxEntries.
+/// Names are valid until statistics reset.
+/// \param sasl SASL handler.
+/// \param entries buffer for statistics.
+/// \param maxEntries number of entries in buffer.
+/// \param frames if not NULL number of measured frames stored here
+int sasl_get_profile(SASL sasl, struct SaslProfileEntry *entries, 
+        int maxEntries, int *frames);
+
+/// Forget collected statistics
+/// \param sasl SASL handler.
+void sasl_reset_profile(SASL sasl);
+
+
+
+// Garbage collector API
+
+
+/// Lua garbage collector statistics.  Times are in milliseconds
+struct SaslGcStats {
+    /// size of Lua heap in Kb
+    int heapSize;
+
+    /// number of finished collection cycles
+    int cycles;
+
+    /// number of cycles finished at once because heap grew too fast
+    int fullCollections;
+
+    /// number of incremental steps
+    int steps;
+
+    /// total time spent on garbage collection
+    double totalTime;
+
+    /// duration of last garbage collection
+    double lastPause;
+
+    /// maximum duration of garbage collection
+    double maxPause;
+};
+
+/// Set Lua garbage collection policy.  By default Lua collector runs when
+/// it decides to, which may cause pauses in the middle of frame.
+/// \param sasl SASL handler.
+/// \param budget maximum time in microseconds spent on garbage collection
+///     each frame.  Pass 0 to use default Lua collector.
+/// \param afterDraw if non-zero garbage collected after drawing of panel,
+///     otherwise after update.
+void sasl_set_gc_policy(SASL sasl, int budget, int afterDraw);
+
+/// Returns garbage collector statistics
+/// \param sasl SASL handler.
+/// \param stats structure to store statistics to.
+void sasl_get_gc_stats(SASL sasl, struct SaslGcStats *stats);
+
+
+
+// Properties statistics API
+
+
+/// Access statistics of single property reference.  Times are in
+/// milliseconds spent in properties callbacks
+struct SaslPropStats {
+    /// name of property
+    const char *name;
+
+    /// number of reads
+    int reads;
+
+    /// number of writes
+    int writes;
+
+    /// number of writes of the same value as previous write
+    int redundantWrites;
+
+    /// time spent in reads
+    double readTime;
+
+    /// time spent in writes
+    double writeTime;
+};
+
+/// Enable or disable counting of properties access.  Counting is
+/// disabled by default and compiled out if libavionics was built with
+/// NO_PROPS_STATS defined
+/// \param sasl SASL handler.
+/// \param enable non-zero to enable counting.
+void sasl_enable_props_stats(SASL sasl, int enable);
+
+/// Copy collected statistics into buffer.
+/// Returns number of accessed properties which may be greater than 
+/// maxStats.  Names are valid until properties are destroyed.
+/// \param sasl SASL handler.
+/// \param stats buffer for statistics.
+/// \param maxStats number of entries in buffer.
+int sasl_get_props_stats(SASL sasl, struct SaslPropStats *stats, 
+        int maxStats);
+
+/// Forget collected statistics
+/// \param sasl SASL handler.
+void sasl_reset_props_stats(SASL sasl);
+
+/// Write collected statistics to CSV file.
+/// Returns zero on success
+/// \param sasl SASL handler.
+/// \param fileName name of file to write.
+int sasl_dump_props_stats(SASL sasl, const char *fileName);
+
+
+
 #if defined(__cplusplus)
 }  /* extern "C" */
 #endif
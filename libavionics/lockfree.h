@@ -0,0 +1,128 @@
+#ifndef __LOCK_FREE_H__
+#define __LOCK_FREE_H__
+
+
+#include <vector>
+#include "thread.h"
+
+
+namespace xa {
+
+
+/// Passes values from one producer thread to one consumer thread
+/// without locks.  Producer fills back buffer and publishes it, consumer
+/// picks up latest published buffer.  Neither side ever waits
+template <typename T>
+class TripleBuffer
+{
+    private:
+        /// Flag of published buffer not seen by consumer
+        enum { FRESH = 4 };
+
+        /// Buffers
+        T buffers[3];
+
+        /// Index of buffer filled by producer
+        int back;
+
+        /// Index of buffer read by consumer
+        int front;
+
+        /// Index of buffer exchanged between threads and fresh flag
+        AtomicInt middle;
+
+    public:
+        TripleBuffer(): back(0), front(2), middle(1) { };
+
+    public:
+        /// Returns buffer to fill.  Called by producer only.
+        /// Buffer contains value published two times ago or default one
+        T& getBack() { return buffers[back]; };
+
+        /// Publish back buffer.  Called by producer only
+        void publish() { back = middle.exchange(back | FRESH) & 3; };
+
+        /// Switch to latest published buffer.  Called by consumer only.
+        /// Returns true if new buffer was published since last call
+        bool update() {
+            if (! (middle.get() & FRESH))
+                return false;
+            front = middle.exchange(front) & 3;
+            return true;
+        };
+
+        /// Returns latest buffer seen by consumer.  Called by consumer only
+        T& getFront() { return buffers[front]; };
+
+        /// Set all buffers to value.  Should be called when neither
+        /// thread uses buffer
+        void reset(const T &value) {
+            for (int i = 0; i < 3; i++)
+                buffers[i] = value;
+            middle.set(middle.get() & 3);
+        };
+
+    private:
+        TripleBuffer(const TripleBuffer&);
+        TripleBuffer& operator = (const TripleBuffer&);
+};
+
+
+/// Bounded queue of one producer and one consumer thread without locks.
+/// Items are never destroyed, so storage allocated by them is reused
+template <typename T>
+class SpscQueue
+{
+    private:
+        /// Ring of items.  One item is always unused
+        std::vector<T> items;
+
+        /// Index of first item to pop.  Changed by consumer only
+        AtomicInt head;
+
+        /// Index of next item to push.  Changed by producer only
+        AtomicInt tail;
+
+    public:
+        /// Create queue
+        /// \param capacity maximum number of items in queue.
+        SpscQueue(int capacity): items(capacity + 1) { };
+
+    public:
+        /// Returns item to fill or NULL if queue is full.
+        /// Called by producer only
+        T* getTail() {
+            long next = (tail.get() + 1) % (long)items.size();
+            if (next == head.get())
+                return NULL;
+            return &items[tail.get()];
+        };
+
+        /// Make filled item available to consumer.  Called by producer only
+        void push() { tail.set((tail.get() + 1) % (long)items.size()); };
+
+        /// Returns first item or NULL if queue is empty.
+        /// Called by consumer only
+        T* getHead() {
+            if (head.get() == tail.get())
+                return NULL;
+            return &items[head.get()];
+        };
+
+        /// Remove first item.  Called by consumer only
+        void pop() { head.set((head.get() + 1) % (long)items.size()); };
+
+        /// Remove all items.  Should be called when neither thread uses queue
+        void clear() { head.set(0); tail.set(0); };
+
+    private:
+        SpscQueue(const SpscQueue&);
+        SpscQueue& operator = (const SpscQueue&);
+};
+
+
+};
+
+
+#endif
+
@@ -1,4 +1,5 @@
 #include "log.h"
+#include "logqueue.h"
 
 #include <string>
 #include <assert.h>
@@ -29,6 +30,7 @@ static void defaultLogger(int level, const char *message)
 
 Log::Log()
 {
+    queue = NULL;
     setLogger(NULL, NULL);
 }
 
@@ -45,7 +47,38 @@ void Log::log(int level, const char *message, va_list args)
     va_end(cp);
     char *buf = (char*)alloca(msgLen + 1);
     vsnprintf(buf, msgLen + 1, message, args);
-    callback(level, buf);
+    if (queue)
+        queue->add(level, buf);
+    else
+        callback(level, buf);
+}
+
+
+void LogQueue::add(int level, const char *message)
+{
+    MutexLock lock(mutex);
+    messages.push_back(std::make_pair(level, std::string(message)));
+    count.add(1);
+}
+
+
+void LogQueue::flush(Log &log)
+{
+    if (! count.get())
+        return;
+
+    std::vector<std::pair<int, std::string> > stored;
+    {
+        MutexLock lock(mutex);
+        stored.swap(messages);
+        count.set(0);
+    }
+
+    void *ref;
+    sasl_log_callback callback = log.getLogger(&ref);
+    for (std::vector<std::pair<int, std::string> >::iterator i = 
+            stored.begin(); i != stored.end(); i++)
+        callback((*i).first, (*i).second.c_str());
 }
 
 
@@ -6,6 +6,9 @@
 
 namespace xa {
 
+class LogQueue;
+
+
 // logger
 class Log
 {
@@ -16,6 +19,9 @@ class Log
         /// Data for logger function
         void *ref;
 
+        /// Queue to store messages in or NULL to log immediately
+        LogQueue *queue;
+
     public:
         /// Create default logger
         Log();
@@ -43,6 +49,10 @@ class Log
         /// get logger function
         sasl_log_callback getLogger(void **ref);
 
+        /// Store messages in queue instead of passing them to logger.
+        /// Used by threads other than main one
+        void setQueue(LogQueue *queue) { this->queue = queue; };
+
         /// register logger functions in Lua
         void exportToLua(Luna &lua);
 };
@@ -0,0 +1,42 @@
+#ifndef __LOG_QUEUE_H__
+#define __LOG_QUEUE_H__
+
+
+#include <string>
+#include <vector>
+#include "log.h"
+#include "thread.h"
+
+
+namespace xa {
+
+
+/// Messages logged by threads other than main one.
+/// Logger functions are not thread-safe, so messages are stored until
+/// main thread passes them to logger
+class LogQueue
+{
+    private:
+        /// Protects messages
+        Mutex mutex;
+
+        /// Stored messages levels and texts
+        std::vector<std::pair<int, std::string> > messages;
+
+        /// Number of stored messages
+        AtomicInt count;
+
+    public:
+        /// Store message
+        void add(int level, const char *message);
+
+        /// Pass stored messages to log.  Called by main thread
+        void flush(Log &log);
+};
+
+
+};
+
+
+#endif
+
@@ -15,11 +15,18 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <poll.h>
 #else
 #include <winsock2.h>
 #endif
 #include <errno.h>
 #include <cstdio>
+#include <vector>
+
+#if defined(__linux__) && ! defined(WINDOWS)
+#define USE_EPOLL
+#include <sys/epoll.h>
+#endif
 
 
 // MSG_NOSIGNAL does not exist on OS X and is never sent anyway
@@ -105,6 +112,13 @@ void NetBuf::addDouble(double v)
 
 
 
+void NetBuf::setInt32(size_t pos, int v)
+{
+    uint32_t l = htonl((uint32_t)v);
+    memcpy(data + pos, &l, sizeof(l));
+}
+
+
 void NetBuf::remove(size_t size) {
     if (size >= filled)
         filled = 0;
@@ -155,6 +169,36 @@ int xa::getPropTypeSize(int type)
 }
 
 
+int xa::getMaxPropId(int version)
+{
+    return (3 <= version) ? 0x7FFFFFFF : 255;
+}
+
+
+int xa::getPropIdSize(int version)
+{
+    return (3 <= version) ? 4 : 1;
+}
+
+
+void xa::addPropId(NetBuf &buffer, int version, int id)
+{
+    if (3 <= version)
+        buffer.addInt32(id);
+    else
+        buffer.addUint8(id);
+}
+
+
+int xa::netToPropId(const unsigned char *data, int version)
+{
+    if (3 <= version)
+        return netToInt32(data);
+    else
+        return data[0];
+}
+
+
 /// put socket to non-blocking mode
 static int makeNonBlock(int sock)
 {
@@ -185,10 +229,213 @@ static void closeSocket(int sock)
 }
 
 
+/// Returns true if last socket operation failed because it would block
+static bool wouldBlock()
+{
+#ifdef WINDOWS
+    return WSAEWOULDBLOCK == WSAGetLastError();
+#else
+    return (EAGAIN == errno) || (EWOULDBLOCK == errno);
+#endif
+}
+
+
+/// Maximum number of reads or writes of single socket per update.
+/// Socket stays ready if limit reached so next update continues
+#define MAX_IO_PER_UPDATE 32
+
+
+
+NetPoller::NetPoller(Log &log): log(log)
+{
+#ifdef USE_EPOLL
+    epollFd = epoll_create(64);
+    if (0 > epollFd)
+        log.error("can't create epoll descriptor\n");
+#else
+    epollFd = -1;
+#endif
+}
+
+
+NetPoller::~NetPoller()
+{
+#ifdef USE_EPOLL
+    if (0 <= epollFd)
+        close(epollFd);
+#endif
+}
+
+
+int NetPoller::add(int sock, NetEvents *events)
+{
+#ifdef USE_EPOLL
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+    ev.data.ptr = events;
+    if ((0 > epollFd) || epoll_ctl(epollFd, EPOLL_CTL_ADD, sock, &ev)) {
+        log.error("can't add socket to epoll\n");
+        return -1;
+    }
+#endif
+    sockets[sock] = events;
+    return 0;
+}
+
+
+void NetPoller::remove(int sock)
+{
+    std::map<int, NetEvents*>::iterator i = sockets.find(sock);
+    if (i == sockets.end())
+        return;
+#ifdef USE_EPOLL
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, sock, &ev);
+#endif
+    sockets.erase(i);
+}
+
+
+bool NetPoller::hasPendingEvents() const
+{
+    for (std::map<int, NetEvents*>::const_iterator i = sockets.begin();
+            i != sockets.end(); i++)
+        if ((*i).second->readable || (*i).second->writable)
+            return true;
+    return false;
+}
+
+
+#if defined(USE_EPOLL)
+
+int NetPoller::wait(int timeout)
+{
+    if (sockets.empty())
+        return 0;
+
+    // sockets stopped at MAX_IO_PER_UPDATE are still ready, but no
+    // new event would wake us, so just poll
+    if (hasPendingEvents())
+        timeout = 0;
+
+    // edge-triggered: flags stay set till operation would block
+    struct epoll_event ev[64];
+    int res = epoll_wait(epollFd, ev, 64, timeout);
+    if (0 > res)
+        return (EINTR == errno) ? 0 : -1;
+
+    for (int i = 0; i < res; i++) {
+        NetEvents *events = (NetEvents*)ev[i].data.ptr;
+        if (ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            events->readable = true;
+        if (ev[i].events & EPOLLOUT)
+            events->writable = true;
+    }
+    return 0;
+}
+
+#elif defined(WINDOWS)
+
+int NetPoller::wait(int timeout)
+{
+    if (sockets.empty())
+        return 0;
+
+    // sockets stopped at MAX_IO_PER_UPDATE are still ready, but no
+    // new event would wake us, so just poll
+    if (hasPendingEvents())
+        timeout = 0;
+
+    // sockets which are already ready are not watched, so level-triggered
+    // select doesn't return immediately
+    fd_set readSet, writeSet;
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+    int count = 0;
+    for (std::map<int, NetEvents*>::iterator i = sockets.begin();
+            i != sockets.end(); i++)
+    {
+        if (! (*i).second->readable) {
+            FD_SET((unsigned)(*i).first, &readSet);
+            count++;
+        }
+        if (! (*i).second->writable) {
+            FD_SET((unsigned)(*i).first, &writeSet);
+            count++;
+        }
+    }
+    if (! count)
+        return 0;
+
+    struct timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    if (0 > select(0, &readSet, &writeSet, NULL, &tv))
+        return -1;
+
+    for (std::map<int, NetEvents*>::iterator i = sockets.begin();
+            i != sockets.end(); i++)
+    {
+        if (FD_ISSET((unsigned)(*i).first, &readSet))
+            (*i).second->readable = true;
+        if (FD_ISSET((unsigned)(*i).first, &writeSet))
+            (*i).second->writable = true;
+    }
+    return 0;
+}
+
+#else
+
+int NetPoller::wait(int timeout)
+{
+    if (sockets.empty())
+        return 0;
+
+    // sockets stopped at MAX_IO_PER_UPDATE are still ready, but no
+    // new event would wake us, so just poll
+    if (hasPendingEvents())
+        timeout = 0;
+
+    std::vector<struct pollfd> fds(sockets.size());
+    int n = 0;
+    for (std::map<int, NetEvents*>::iterator i = sockets.begin();
+            i != sockets.end(); i++, n++)
+    {
+        // sockets which are already ready are not watched, so 
+        // level-triggered poll doesn't return immediately
+        fds[n].fd = (*i).first;
+        fds[n].events = ((*i).second->readable ? 0 : POLLIN) | 
+            ((*i).second->writable ? 0 : POLLOUT);
+        fds[n].revents = 0;
+    }
+
+    int res = poll(&fds[0], fds.size(), timeout);
+    if (0 > res)
+        return (EINTR == errno) ? 0 : -1;
+
+    n = 0;
+    for (std::map<int, NetEvents*>::iterator i = sockets.begin();
+            i != sockets.end(); i++, n++)
+    {
+        if (fds[n].revents & (POLLIN | POLLHUP | POLLERR))
+            (*i).second->readable = true;
+        if (fds[n].revents & POLLOUT)
+            (*i).second->writable = true;
+    }
+    return 0;
+}
+
+#endif
+
+
+
 AsyncCon::AsyncCon(Log &log): log(log)
 {
     sock = 0;
     receiver = NULL;
+    poller = NULL;
 }
 
 
@@ -203,12 +450,20 @@ int AsyncCon::setSocket(int socket)
     if (socket) {
         if (makeNonBlock(socket))
             return -1;
+        if (poller && poller->add(socket, &events))
+            return -1;
     }
     sock = socket;
     return 0;
 }
 
 
+void AsyncCon::setPoller(NetPoller *poller)
+{
+    this->poller = poller;
+}
+
+
 void AsyncCon::send(const unsigned char *data, size_t size)
 {
     sendBuffer.add(data, size);
@@ -311,8 +566,9 @@ int AsyncCon::sendMore()
             MSG_NOSIGNAL | MSG_DONTWAIT);
 #endif
     if (0 >= (int)sent) {
-        if (EAGAIN != errno)
+        if (! wouldBlock())
             return -1;
+        events.writable = false;
     } else {
         sendBuffer.remove(sent);
     }
@@ -331,11 +587,14 @@ int AsyncCon::recvMore()
     size_t received = ::recv(sock, recvBuffer.getFreeSpace(), 2048,
             MSG_NOSIGNAL | MSG_DONTWAIT);
 #endif
-    if (0 >= (int)received) {
-        if (EAGAIN != errno)
+    if (! received) {
+        log.debug("connection closed by peer\n");
+        return -1;
+    } else if (0 > (int)received) {
+        if (! wouldBlock())
             return -1;
-        else
-            return 0;
+        events.readable = false;
+        return 0;
     } else {
         recvBuffer.increaseFilled(received);
     }
@@ -349,13 +608,19 @@ int AsyncCon::recvMore()
 
 int AsyncCon::update()
 {
-    if (sendBuffer.getFilled() && canSend(sock))
+    if (! poller) {
+        events.writable = sendBuffer.getFilled() && canSend(sock);
+        events.readable = canReceive(sock);
+    }
+
+    for (int i = 0; (i < MAX_IO_PER_UPDATE) && events.writable && 
+            sendBuffer.getFilled(); i++)
         if (sendMore()) {
             log.error("error sending data\n");
             return -1;
         }
 
-    if (canReceive(sock))
+    for (int i = 0; (i < MAX_IO_PER_UPDATE) && events.readable; i++)
         if (recvMore()) {
             log.error("error receiving data\n");
             return -1;
@@ -403,9 +668,12 @@ void AsyncCon::close()
 {
     if (sock) {
         log.debug("closing connection\n");
+        if (poller)
+            poller->remove(sock);
         closeSocket(sock);
         sock = 0;
     }
+    events = NetEvents();
 }
 
 
@@ -445,6 +713,8 @@ int xa::establishConnection(const char *host, int port)
 TcpServer::TcpServer(Log &log): log(log)
 {
     sock = 0;
+    acceptor = NULL;
+    poller = NULL;
 }
 
 
@@ -461,6 +731,12 @@ void TcpServer::setCallback(ConnectionAcceptor *callback)
 }
 
 
+void TcpServer::setPoller(NetPoller *poller)
+{
+    this->poller = poller;
+}
+
+
 static int createSocket(int port)
 {
     struct sockaddr_in serv_addr;
@@ -503,6 +779,11 @@ int TcpServer::start(int port)
         return -1;
     }
 
+    if (poller && poller->add(sock, &events)) {
+        stop();
+        return -1;
+    }
+
     return 0;
 }
 
@@ -510,27 +791,39 @@ int TcpServer::start(int port)
 void TcpServer::stop()
 {
     if (sock) {
+        if (poller)
+            poller->remove(sock);
         closeSocket(sock);
         sock = 0;
     }
+    events = NetEvents();
 }
 
 
 int TcpServer::update()
 {
-    struct sockaddr_in clntAddr;
-    memset(&clntAddr, 0, sizeof(clntAddr));
+    if (! sock)
+        return 0;
+
+    if (! poller)
+        events.readable = canReceive(sock);
+
+    for (int i = 0; (i < MAX_IO_PER_UPDATE) && events.readable; i++) {
+        struct sockaddr_in clntAddr;
+        memset(&clntAddr, 0, sizeof(clntAddr));
 #ifdef WINDOWS
-    int addrlen = sizeof(clntAddr);
+        int addrlen = sizeof(clntAddr);
 #else
-    socklen_t addrlen = sizeof(clntAddr);
+        socklen_t addrlen = sizeof(clntAddr);
 #endif
-
-    if (canReceive(sock)) {
         int clntSock = accept(sock, (struct sockaddr*)&clntAddr, &addrlen);
+        if (-1 == clntSock) {
+            if (! wouldBlock())
+                return -1;
+            events.readable = false;
+            break;
+        }
         log.debug("accept %i", clntSock);
-        if (-1 == clntSock)
-            return (EAGAIN == errno) ? 0 : -1;
 
         if (acceptor)
             acceptor->onConnectionReceived(clntSock);
@@ -7,10 +7,11 @@
 
 
 #include <stdlib.h>
+#include <map>
 
 #ifdef _MSC_VER
 #define uint16_t unsigned __int16
-#define uint32_t unsigned __int16
+#define uint32_t unsigned __int32
 #endif
 
 
@@ -62,6 +63,9 @@ class NetBuf
         /// Append double value to buffer.
         void addDouble(double v);
 
+        /// Overwrite 4 bytes at specified position of buffer
+        void setInt32(size_t pos, int v);
+
         /// Remove data from start of buffer
         void remove(size_t size);
 
@@ -95,6 +99,22 @@ double netToDouble(const unsigned char *data);
 int getPropTypeSize(int type);
 
 
+/// Maximum size of netprops message in protocol version 3
+#define NETPROPS_MAX_FRAME 0x100000
+
+/// Maximum property ID in netprops protocol of specified version
+int getMaxPropId(int version);
+
+/// Returns size of property ID in netprops protocol of specified version
+int getPropIdSize(int version);
+
+/// Append property ID to buffer in format of netprops protocol version
+void addPropId(NetBuf &buffer, int version, int id);
+
+/// Convert property ID from network format of netprops protocol version
+int netToPropId(const unsigned char *data, int version);
+
+
 /// Receiver of network data
 class NetReceiver
 {
@@ -107,6 +127,68 @@ class NetReceiver
 };
 
 
+/// Readiness of socket reported by poller.
+/// Flags are set by poller and cleared when socket operation would block
+struct NetEvents
+{
+    /// Socket has data to receive or connection was closed
+    bool readable;
+
+    /// Socket can send data
+    bool writable;
+
+    NetEvents(): readable(false), writable(false) { };
+};
+
+
+/// Waits for events of many sockets in single system call.
+/// Uses edge-triggered epoll on Linux and poll or select on other systems
+class NetPoller
+{
+    private:
+        /// Logger object
+        Log &log;
+
+        /// epoll descriptor or -1 if epoll isn't used
+        int epollFd;
+
+        /// Registered sockets and their readiness flags
+        std::map<int, NetEvents*> sockets;
+
+    public:
+        /// Create poller
+        NetPoller(Log &log);
+
+        /// Destroy poller
+        ~NetPoller();
+
+    private:
+        /// Poller can't be copied
+        NetPoller(const NetPoller &poller);
+
+        /// Poller can't be copied
+        NetPoller& operator = (const NetPoller &poller);
+
+        /// Returns true if some socket still has readiness flag set
+        bool hasPendingEvents() const;
+
+    public:
+        /// Start watching socket.  Returns non-zero on errors
+        /// \param sock non-blocking socket.
+        /// \param events flags to update on socket events.
+        int add(int sock, NetEvents *events);
+
+        /// Stop watching socket.  Should be called before socket close
+        void remove(int sock);
+
+        /// Wait for events of all registered sockets and update its flags.
+        /// Doesn't block if some socket is still ready.
+        /// Returns non-zero on errors
+        /// \param timeout maximum time to wait in milliseconds.
+        int wait(int timeout);
+};
+
+
 /// Low-level async net routinues
 class AsyncCon
 {
@@ -126,6 +208,12 @@ class AsyncCon
         /// Data receiver callback
         NetReceiver *receiver;
 
+        /// Poller watching socket or NULL if socket checked on each update
+        NetPoller *poller;
+
+        /// Readiness of socket
+        NetEvents events;
+
     public:
         /// Create async net struture
         AsyncCon(Log &log);
@@ -135,9 +223,13 @@ class AsyncCon
 
     public:
         /// Set socket.
-        /// Turns socket to non-blocking mode
+        /// Turns socket to non-blocking mode and registers it in poller
         int setSocket(int sock);
 
+        /// Set poller watching connection socket.
+        /// Should be called before setSocket
+        void setPoller(NetPoller *poller);
+
         /// Schedule data to send
         void send(const unsigned char *data, size_t size);
 
@@ -199,6 +291,12 @@ class TcpServer
         /// Connection acceptor callback
         ConnectionAcceptor *acceptor;
 
+        /// Poller watching server socket or NULL
+        NetPoller *poller;
+
+        /// Readiness of server socket
+        NetEvents events;
+
     public:
         /// create server object
         TcpServer(Log &log);
@@ -210,6 +308,9 @@ class TcpServer
         /// Set acceptor callback
         void setCallback(ConnectionAcceptor *acceptor);
 
+        /// Set poller watching server socket.  Should be called before start
+        void setPoller(NetPoller *poller);
+
         /// open server socket
         int start(int port);
 
@@ -1,12 +1,16 @@
 #include "luna.h"
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #ifndef WINDOWS
 #include <dirent.h>
 #else
 #include <windows.h>
+#include <direct.h>
 #endif
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
 
 
 using namespace xa;
@@ -127,6 +131,171 @@ static int luaListFiles(lua_State *L)
 #endif
 
 
+/// Name of directory with compiled scripts.  Created next to sources
+#define BYTECODE_DIR ".saslc"
+
+/// Signature of compiled script file
+#define BYTECODE_MAGIC "SASLC1 " LUA_RELEASE "\n"
+
+
+/// Header of compiled script file
+struct BytecodeHeader
+{
+    /// Signature of file format and Lua version
+    char magic[32];
+
+    /// Modification time of source file
+    double mtime;
+
+    /// Size of source file
+    double size;
+};
+
+
+/// Returns path to compiled version of script
+static std::string getBytecodePath(const std::string &fileName, 
+        std::string &dir)
+{
+    std::string::size_type pos = fileName.find_last_of("/\\");
+    if (std::string::npos == pos) {
+        dir = BYTECODE_DIR;
+        return dir + "/" + fileName + "c";
+    } else {
+        dir = fileName.substr(0, pos + 1) + BYTECODE_DIR;
+        return dir + "/" + fileName.substr(pos + 1) + "c";
+    }
+}
+
+
+/// Fill header of compiled script for source file.
+/// Returns false if source file doesn't exists
+static bool makeBytecodeHeader(const char *fileName, BytecodeHeader &header)
+{
+    struct stat st;
+    if (stat(fileName, &st))
+        return false;
+
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, BYTECODE_MAGIC, sizeof(header.magic) - 1);
+    header.mtime = st.st_mtime;
+    header.size = st.st_size;
+    return true;
+}
+
+
+/// Load compiled script if it is not older than source.
+/// Returns true if compiled script was loaded and pushed into Lua stack
+static bool loadBytecode(lua_State *L, const char *fileName, 
+        const std::string &path, const BytecodeHeader &header)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (! f)
+        return false;
+
+    BytecodeHeader cached;
+    std::string code;
+    bool valid = (1 == fread(&cached, sizeof(cached), 1, f)) &&
+        (! memcmp(&cached, &header, sizeof(header)));
+    if (valid) {
+        char buf[4096];
+        size_t len;
+        while (0 < (len = fread(buf, 1, sizeof(buf), f)))
+            code.append(buf, len);
+        valid = ! ferror(f);
+    }
+    fclose(f);
+
+    if ((! valid) || code.empty())
+        return false;
+
+    std::string chunkName = std::string("@") + fileName;
+    if (luaL_loadbuffer(L, code.data(), code.size(), chunkName.c_str())) {
+        // compiled by incompatible Lua version
+        lua_pop(L, 1);
+        return false;
+    }
+
+    return true;
+}
+
+
+/// Lua dump writer
+static int writeBytecode(lua_State *L, const void *p, size_t size, void *ud)
+{
+    ((std::string*)ud)->append((const char*)p, size);
+    return 0;
+}
+
+
+/// Save function on top of Lua stack as compiled script.
+/// Errors are ignored: scripts may be stored on read only media
+static void saveBytecode(lua_State *L, const std::string &dir,
+        const std::string &path, const BytecodeHeader &header)
+{
+    std::string code;
+    if (lua_dump(L, writeBytecode, &code) || code.empty())
+        return;
+
+#ifdef WINDOWS
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+
+    // write to temporary file so other instance never reads partial file
+    std::string tmpPath = path + ".tmp";
+    FILE *f = fopen(tmpPath.c_str(), "wb");
+    if (! f)
+        return;
+    bool ok = (1 == fwrite(&header, sizeof(header), 1, f)) &&
+        (1 == fwrite(code.data(), code.size(), 1, f));
+    ok = (! fclose(f)) && ok;
+
+    if (ok) {
+        remove(path.c_str());
+        ok = ! rename(tmpPath.c_str(), path.c_str());
+    }
+    if (! ok)
+        remove(tmpPath.c_str());
+}
+
+
+/// Load script like loadfile but use compiled version stored in
+/// BYTECODE_DIR if it is up to date.  Compiled version created or updated
+/// on each load of changed script.
+/// Returns function or nil and error message
+static int luaLoadCachedFile(lua_State *L)
+{
+    const char *fileName = lua_tostring(L, 1);
+    if (! fileName) {
+        lua_pushnil(L);
+        lua_pushstring(L, "file name expected");
+        return 2;
+    }
+
+    BytecodeHeader header;
+    if (! makeBytecodeHeader(fileName, header)) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "cannot open %s", fileName);
+        return 2;
+    }
+
+    std::string dir;
+    std::string path = getBytecodePath(fileName, dir);
+    if (loadBytecode(L, fileName, path, header))
+        return 1;
+
+    if (luaL_loadfile(L, fileName)) {
+        lua_pushnil(L);
+        lua_insert(L, -2);
+        return 2;
+    }
+
+    saveBytecode(L, dir, path, header);
+    return 1;
+}
+
+
 Luna::Luna(sasl_lua_creator_callback luaCreator,
                 sasl_lua_destroyer_callback luaDestroyer)
 {
@@ -144,6 +313,7 @@ Luna::Luna(sasl_lua_creator_callback luaCreator,
         lua_register(lua, "bitor", luaBitOr);
         lua_register(lua, "bitxor", luaBitXor);
         lua_register(lua, "listFiles", luaListFiles);
+        lua_register(lua, "loadCachedFile", luaLoadCachedFile);
 
         lua_newtable(lua);
         lua_setfield(lua, LUA_REGISTRYINDEX, "xavionics");
@@ -238,6 +408,7 @@ void Luna::unRef(int ref)
 {
     lua_getfield(lua, LUA_REGISTRYINDEX, "xavionics");
     luaL_unref(lua, -1, ref);
+    lua_pop(lua, 1);
 }
 
 void Luna::storeAvionics(Avionics *avionics)
@@ -0,0 +1,358 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include "libavionics.h"
+#include "avionics.h"
+
+
+using namespace xa;
+
+
+/// Number of components written to log by dump
+#define DUMP_ENTRIES 20
+
+
+
+Profiler::Profiler(Luna &lua, Log &log): lua(lua), log(log)
+{
+    enabled = false;
+    nextId = 0;
+    frames = 0;
+    logPeriod = 0;
+    lastLogTime = 0;
+    graphics = NULL;
+}
+
+
+void Profiler::setEnabled(bool enabled, int logPeriod)
+{
+    this->logPeriod = logPeriod;
+    lastLogTime = timer.getTime();
+    calls.clear();
+
+    if (this->enabled == enabled)
+        return;
+
+    // profiling wrappers are installed only while profiler is enabled
+    lua_State *L = lua.getLua();
+    lua_getglobal(L, "setProfilerHooks");
+    lua_pushboolean(L, enabled);
+    if (lua_pcall(L, 1, 0, 0)) {
+        log.error("Error switching profiler: %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return;
+    }
+    this->enabled = enabled;
+}
+
+
+void Profiler::getGraphicsStats(int &triangles, int &batches)
+{
+    triangles = batches = 0;
+    if (graphics && (4 <= graphics->version) && graphics->get_statistics)
+        graphics->get_statistics(graphics, &triangles, NULL, &batches);
+}
+
+
+void Profiler::addEntry(int id, const char *name, const char *source,
+        int line)
+{
+    if ((! enabled) || (0 > id))
+        return;
+
+    // location of code is only a label, different instances of
+    // same component have separate entries
+    char location[32];
+    sprintf(location, ":%i", line);
+
+    Entry entry;
+    entry.name = std::string(name ? name : "<unnamed>") + " (" +
+        (source ? source : "?") + location + ")";
+    entry.calls[UPDATE] = entry.calls[DRAW] = 0;
+    entry.time[UPDATE] = entry.time[DRAW] = 0;
+    entry.selfTime[UPDATE] = entry.selfTime[DRAW] = 0;
+    entry.triangles = entry.batches = 0;
+
+    if ((int)entriesById.size() <= id)
+        entriesById.resize(id + 1, -1);
+    entriesById[id] = entries.size();
+    entries.push_back(entry);
+}
+
+
+void Profiler::begin(int kind, int id)
+{
+    if (! enabled)
+        return;
+
+    // unknown components are still pushed to keep calls balanced
+    Call call;
+    call.entry = hasEntry(id) ? entriesById[id] : -1;
+    call.kind = (DRAW == kind) ? DRAW : UPDATE;
+    call.childTime = 0;
+    call.childTriangles = call.childBatches = 0;
+    if (DRAW == call.kind)
+        getGraphicsStats(call.triangles, call.batches);
+    call.start = timer.getPreciseTime();
+    calls.push_back(call);
+}
+
+
+void Profiler::end()
+{
+    if ((! enabled) || calls.empty())
+        return;
+
+    double elapsed = timer.getPreciseTime() - calls.back().start;
+    const Call call = calls.back();
+    calls.pop_back();
+
+    int triangles = 0, batches = 0;
+    if (DRAW == call.kind) {
+        getGraphicsStats(triangles, batches);
+        triangles -= call.triangles;
+        batches -= call.batches;
+    }
+
+    if (0 <= call.entry) {
+        Entry &entry = entries[call.entry];
+        entry.calls[call.kind]++;
+        entry.time[call.kind] += elapsed;
+        entry.selfTime[call.kind] += elapsed - call.childTime;
+        entry.triangles += triangles - call.childTriangles;
+        entry.batches += batches - call.childBatches;
+    }
+
+    if (! calls.empty()) {
+        Call &parent = calls.back();
+        parent.childTime += elapsed;
+        parent.childTriangles += triangles;
+        parent.childBatches += batches;
+    }
+}
+
+
+void Profiler::startFrame()
+{
+    if (! enabled)
+        return;
+
+    // calls interrupted by Lua errors
+    calls.clear();
+    frames++;
+
+    if (logPeriod) {
+        long now = timer.getTime();
+        if (now - lastLogTime >= logPeriod * 1000) {
+            dump();
+            reset();
+            lastLogTime = now;
+        }
+    }
+}
+
+
+void Profiler::reset()
+{
+    entriesById.assign(entriesById.size(), -1);
+    entries.clear();
+    calls.clear();
+    frames = 0;
+}
+
+
+int Profiler::getProfile(struct SaslProfileEntry *dest, int maxEntries,
+        int *frames) const
+{
+    if (frames)
+        *frames = this->frames;
+
+    int count = entries.size();
+    for (int i = 0; (i < count) && (i < maxEntries); i++) {
+        const Entry &entry = entries[i];
+        SaslProfileEntry &e = dest[i];
+        e.name = entry.name.c_str();
+        e.updateCalls = entry.calls[UPDATE];
+        e.updateTime = entry.time[UPDATE];
+        e.updateSelfTime = entry.selfTime[UPDATE];
+        e.drawCalls = entry.calls[DRAW];
+        e.drawTime = entry.time[DRAW];
+        e.drawSelfTime = entry.selfTime[DRAW];
+        e.triangles = entry.triangles;
+        e.batches = entry.batches;
+    }
+
+    return count;
+}
+
+
+/// Returns total self time of component
+static double getSelfTime(const SaslProfileEntry &entry)
+{
+    return entry.updateSelfTime + entry.drawSelfTime;
+}
+
+
+/// Compare components by self time
+static bool compareSelfTime(const SaslProfileEntry &e1,
+        const SaslProfileEntry &e2)
+{
+    return getSelfTime(e1) > getSelfTime(e2);
+}
+
+
+void Profiler::dump()
+{
+    if ((! frames) || entries.empty())
+        return;
+
+    std::vector<SaslProfileEntry> profile(entries.size());
+    getProfile(&profile[0], profile.size(), NULL);
+    std::sort(profile.begin(), profile.end(), compareSelfTime);
+
+    log.info("Profile of %i frames, milliseconds per frame "
+            "(self time in brackets):", frames);
+    for (int i = 0; (i < (int)profile.size()) && (i < DUMP_ENTRIES); i++) {
+        const SaslProfileEntry &e = profile[i];
+        log.info("  %-24s update %7.3f (%7.3f)  draw %7.3f (%7.3f)  "
+                "triangles %i  batches %i", e.name, 
+                e.updateTime / frames, e.updateSelfTime / frames,
+                e.drawTime / frames, e.drawSelfTime / frames,
+                e.triangles / frames, e.batches / frames);
+    }
+}
+
+
+
+/// Start measuring component call.
+/// Arguments are kind of call, component table and measured function
+static int luaProfilerBegin(lua_State *L)
+{
+    Profiler &profiler = getAvionics(L)->getProfiler();
+    if (! profiler.isEnabled())
+        return 0;
+    if (! lua_istable(L, 2)) {
+        profiler.begin((int)lua_tonumber(L, 1), -1);
+        return 0;
+    }
+
+    // id is stored in component table on first call, so next calls
+    // don't need to build key string
+    int id = -1;
+    lua_pushstring(L, "_profilerId");
+    lua_rawget(L, 2);
+    if (lua_isnumber(L, -1))
+        id = (int)lua_tonumber(L, -1);
+    lua_pop(L, 1);
+    if (0 > id) {
+        id = profiler.newId();
+        lua_pushstring(L, "_profilerId");
+        lua_pushnumber(L, id);
+        lua_rawset(L, 2);
+    }
+
+    if (! profiler.hasEntry(id)) {
+        lua_Debug ar;
+        const char *source = NULL;
+        int line = 0;
+        if (lua_isfunction(L, 3)) {
+            lua_pushvalue(L, 3);
+            if (lua_getinfo(L, ">S", &ar)) {
+                source = ar.short_src;
+                line = ar.linedefined;
+            }
+        }
+        lua_pushstring(L, "name");
+        lua_rawget(L, 2);
+        profiler.addEntry(id, lua_tostring(L, -1), source, line);
+        lua_pop(L, 1);
+    }
+
+    profiler.begin((int)lua_tonumber(L, 1), id);
+    return 0;
+}
+
+
+/// Finish measuring component call
+static int luaProfilerEnd(lua_State *L)
+{
+    getAvionics(L)->getProfiler().end();
+    return 0;
+}
+
+
+/// Enable or disable profiler
+static int luaEnableProfiler(lua_State *L)
+{
+    getAvionics(L)->getProfiler().setEnabled(lua_toboolean(L, 1), 
+            (int)lua_tonumber(L, 2));
+    return 0;
+}
+
+
+/// Forget collected statistics
+static int luaResetProfile(lua_State *L)
+{
+    getAvionics(L)->getProfiler().reset();
+    return 0;
+}
+
+
+/// Returns array of components statistics and number of frames measured
+static int luaGetProfile(lua_State *L)
+{
+    Profiler &profiler = getAvionics(L)->getProfiler();
+
+    int frames = 0;
+    int count = profiler.getProfile(NULL, 0, &frames);
+    std::vector<SaslProfileEntry> profile(count);
+    if (count)
+        profiler.getProfile(&profile[0], count, NULL);
+
+    lua_newtable(L);
+    for (int i = 0; i < count; i++) {
+        const SaslProfileEntry &e = profile[i];
+        lua_newtable(L);
+        lua_pushstring(L, e.name);
+        lua_setfield(L, -2, "name");
+        lua_pushnumber(L, e.updateCalls);
+        lua_setfield(L, -2, "updateCalls");
+        lua_pushnumber(L, e.updateTime);
+        lua_setfield(L, -2, "updateTime");
+        lua_pushnumber(L, e.updateSelfTime);
+        lua_setfield(L, -2, "updateSelfTime");
+        lua_pushnumber(L, e.drawCalls);
+        lua_setfield(L, -2, "drawCalls");
+        lua_pushnumber(L, e.drawTime);
+        lua_setfield(L, -2, "drawTime");
+        lua_pushnumber(L, e.drawSelfTime);
+        lua_setfield(L, -2, "drawSelfTime");
+        lua_pushnumber(L, e.triangles);
+        lua_setfield(L, -2, "triangles");
+        lua_pushnumber(L, e.batches);
+        lua_setfield(L, -2, "batches");
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushnumber(L, frames);
+
+    return 2;
+}
+
+
+void xa::exportProfilerToLua(Luna &lua)
+{
+    lua_State *L = lua.getLua();
+
+    lua_pushnumber(L, Profiler::UPDATE);
+    lua_setglobal(L, "PROFILE_UPDATE");
+    lua_pushnumber(L, Profiler::DRAW);
+    lua_setglobal(L, "PROFILE_DRAW");
+
+    lua_register(L, "profilerBegin", luaProfilerBegin);
+    lua_register(L, "profilerEnd", luaProfilerEnd);
+    lua_register(L, "enableProfiler", luaEnableProfiler);
+    lua_register(L, "resetProfile", luaResetProfile);
+    lua_register(L, "getProfile", luaGetProfile);
+}
+
@@ -0,0 +1,185 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+
+#include <string>
+#include <vector>
+#include "luna.h"
+#include "log.h"
+#include "rttimer.h"
+#include "libavcallbacks.h"
+
+
+struct SaslProfileEntry;
+
+
+namespace xa {
+
+/// Collects time spent in update and draw functions of each component
+class Profiler
+{
+    public:
+        /// Types of measured calls
+        enum Kind {
+            /// Component update
+            UPDATE = 0,
+            /// Component draw
+            DRAW = 1
+        };
+
+    private:
+        /// Statistics of single component
+        struct Entry
+        {
+            /// Name of component
+            std::string name;
+
+            /// Number of calls of each kind
+            int calls[2];
+
+            /// Time spent in calls including subcomponents
+            double time[2];
+
+            /// Time spent in calls excluding subcomponents
+            double selfTime[2];
+
+            /// Triangles drawn by component excluding subcomponents
+            int triangles;
+
+            /// Batches flushed while component was drawn
+            int batches;
+        };
+
+        /// Call in progress
+        struct Call
+        {
+            /// Index of entry or -1 if component isn't known
+            int entry;
+
+            /// Kind of call
+            int kind;
+
+            /// Time of call start
+            double start;
+
+            /// Time spent in subcomponents
+            double childTime;
+
+            /// Graphics statistics at call start
+            int triangles, batches;
+
+            /// Triangles and batches of subcomponents
+            int childTriangles, childBatches;
+        };
+
+        /// Index of entry by component id or -1 if component wasn't
+        /// measured since last reset
+        std::vector<int> entriesById;
+
+        /// Next free component id
+        int nextId;
+
+        /// Statistics of components
+        std::vector<Entry> entries;
+
+        /// Stack of calls in progress
+        std::vector<Call> calls;
+
+        /// True if profiler is collecting data
+        bool enabled;
+
+        /// Number of frames measured
+        int frames;
+
+        /// Number of seconds between dumps to log or zero
+        int logPeriod;
+
+        /// Time of last dump to log
+        long lastLogTime;
+
+        /// Timer for measurements
+        RtTimer timer;
+
+        /// Graphics callbacks used to count primitives
+        SaslGraphicsCallbacks *graphics;
+
+        /// Lua state
+        Luna &lua;
+
+        /// Logger
+        Log &log;
+
+    public:
+        /// Create disabled profiler
+        Profiler(Luna &lua, Log &log);
+
+    public:
+        /// Enable or disable profiler.
+        /// \param enabled true to collect statistics.
+        /// \param logPeriod seconds between dumps to log or 0 to disable.
+        void setEnabled(bool enabled, int logPeriod);
+
+        /// Returns true if profiler is collecting data
+        bool isEnabled() const { return enabled; }
+
+        /// Set graphics callbacks used to count primitives
+        void setGraphics(SaslGraphicsCallbacks *graphics) { 
+            this->graphics = graphics; 
+        }
+
+        /// Allocate id of component.  Ids are never reused, so
+        /// identical instances of same component are measured separately
+        int newId() { return nextId++; }
+
+        /// Returns true if component has statistics entry
+        /// \param id component id.
+        bool hasEntry(int id) const { 
+            return (0 <= id) && (id < (int)entriesById.size()) && 
+                (0 <= entriesById[id]);
+        }
+
+        /// Create statistics entry of component
+        /// \param id component id.
+        /// \param name component name.
+        /// \param source chunk name of measured function.
+        /// \param line line where measured function defined.
+        void addEntry(int id, const char *name, const char *source, 
+                int line);
+
+        /// Start measuring call of component
+        /// \param kind type of call.
+        /// \param id component id passed to addEntry.
+        void begin(int kind, int id);
+
+        /// Finish measuring of last started call
+        void end();
+
+        /// Called on start of each frame
+        void startFrame();
+
+        /// Forget all collected data
+        void reset();
+
+        /// Copy collected statistics.  Returns number of entries available
+        /// \param entries buffer for statistics.
+        /// \param maxEntries size of buffer.
+        /// \param frames if not NULL number of frames measured stored here.
+        int getProfile(struct SaslProfileEntry *entries, int maxEntries, 
+                int *frames) const;
+
+        /// Write statistics of most expensive components to log
+        void dump();
+
+    private:
+        /// Read graphics counters
+        void getGraphicsStats(int &triangles, int &batches);
+};
+
+
+/// Register profiler functions in Lua
+void exportProfilerToLua(Luna &lua);
+
+};
+
+#endif
+
@@ -2,6 +2,8 @@
 
 #include "avionics.h"
 #include <string.h>
+#include <math.h>
+#include <vector>
 
 
 using namespace xa;
@@ -103,7 +105,10 @@ static int luaCreateProp(lua_State *L)
     return 1;
 }
 
-/// Lua wrapper for createProp
+/// Lua wrapper for registerFuncProp.
+/// Optional 6th argument is caching policy of value: "frame" to call
+/// getter once per frame, "set" to call getter on first read after
+/// setter or number of milliseconds to keep value
 static int luaCreateFuncProp(lua_State *L)
 {
     if (lua_isnil(L, 1) || lua_isnil(L, 2) || (! lua_isfunction(L, 3)) ||
@@ -117,13 +122,27 @@ static int luaCreateFuncProp(lua_State *L)
     std::string propName = lua_tostring(L, 1);
     int type = getPropType(lua_tostring(L, 2));
     int maxSize = lua_tonumber(L, 5);
+
+    Properties::FuncPropCache cache = Properties::CACHE_NONE;
+    long cacheTime = 0;
+    if (lua_type(L, 6) == LUA_TNUMBER) {
+        cache = Properties::CACHE_TIME;
+        cacheTime = (long)lua_tonumber(L, 6);
+    } else if (lua_isstring(L, 6)) {
+        std::string policy = lua_tostring(L, 6);
+        if ("frame" == policy)
+            cache = Properties::CACHE_FRAME;
+        else if ("set" == policy)
+            cache = Properties::CACHE_UNTIL_SET;
+    }
+
     lua_pushvalue(L, 3);
     int getter = lua.addRef();
     lua_pushvalue(L, 4);
     int setter = lua.addRef();
    
     SaslPropRef p = getAvionics(L)->getProps().registerFuncProp(propName, type, 
-            maxSize, getter, setter);
+            maxSize, getter, setter, cache, cacheTime);
     if (p)
         lua_pushlightuserdata(L, p);
     else
@@ -200,10 +219,10 @@ static int luaSetPropf(lua_State *L)
 static int luaGetPropd(lua_State *L)
 {
     SaslPropRef prop = (SaslPropRef)lua_touserdata(L, 1);
-    float dflt = 0;
+    double dflt = 0;
     
     if (! lua_isnil(L, 2))
-        dflt = (double)lua_tonumber(L, 2);
+        dflt = lua_tonumber(L, 2);
 
     lua_pushnumber(L, getAvionics(L)->getProps().getPropd(prop, dflt));
 
@@ -215,7 +234,7 @@ static int luaGetPropd(lua_State *L)
 static int luaSetPropd(lua_State *L)
 {
     SaslPropRef prop = (SaslPropRef)lua_touserdata(L, 1);
-    double value = (float)lua_tonumber(L, 2);
+    double value = lua_tonumber(L, 2);
     getAvionics(L)->getProps().setProp(prop, value);
     return 0;
 }
@@ -229,7 +248,7 @@ static int luaGetProps(lua_State *L)
     if (! lua_isnil(L, 2))
         dflt = lua_tostring(L, 2);
 
-    lua_pushstring(L, getAvionics(L)->getProps().getProps(prop, dflt).c_str());
+    getAvionics(L)->getProps().pushPropString(prop, dflt);
 
     return 1;
 }
@@ -245,6 +264,184 @@ static int luaSetProps(lua_State *L)
 }
 
 
+/// Read elements of array property into Lua table.
+/// Arguments are property, offset, count and optional table to reuse.
+/// Returns table and number of elements read
+template <typename T>
+static int getPropArray(lua_State *L)
+{
+    // scratch buffer shared by all calls
+    static std::vector<T> buffer;
+
+    SaslPropRef prop = (SaslPropRef)lua_touserdata(L, 1);
+    int offset = (int)lua_tonumber(L, 2);
+    int count = (int)lua_tonumber(L, 3);
+
+    int read = 0;
+    if (prop && (0 < count)) {
+        if ((int)buffer.size() < count)
+            buffer.resize(count);
+        read = getAvionics(L)->getProps().getPropArray(prop, offset, count, 
+                &buffer[0]);
+        if (0 > read)
+            read = 0;
+    }
+
+    if (lua_istable(L, 4))
+        lua_pushvalue(L, 4);
+    else
+        lua_createtable(L, read, 0);
+
+    for (int i = 0; i < read; i++) {
+        lua_pushnumber(L, buffer[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    // reused table may hold elements of longer read
+    if (lua_istable(L, 4)) {
+        for (int i = read + 1; ; i++) {
+            lua_rawgeti(L, -1, i);
+            bool empty = lua_isnil(L, -1);
+            lua_pop(L, 1);
+            if (empty)
+                break;
+            lua_pushnil(L);
+            lua_rawseti(L, -2, i);
+        }
+    }
+
+    lua_pushnumber(L, read);
+    return 2;
+}
+
+
+/// Write elements of array property from Lua table.
+/// Arguments are property, offset, table and optional count of elements
+template <typename T>
+static int setPropArray(lua_State *L)
+{
+    static std::vector<T> buffer;
+
+    SaslPropRef prop = (SaslPropRef)lua_touserdata(L, 1);
+    int offset = (int)lua_tonumber(L, 2);
+    if ((! prop) || (! lua_istable(L, 3)))
+        return 0;
+
+    int count = lua_isnumber(L, 4) ? (int)lua_tonumber(L, 4) : 
+        (int)lua_objlen(L, 3);
+    if (0 >= count)
+        return 0;
+
+    if ((int)buffer.size() < count)
+        buffer.resize(count);
+    for (int i = 0; i < count; i++) {
+        lua_rawgeti(L, 3, i + 1);
+        buffer[i] = (T)lua_tonumber(L, -1);
+        lua_pop(L, 1);
+    }
+
+    getAvionics(L)->getProps().setPropArray(prop, offset, count, &buffer[0]);
+    return 0;
+}
+
+
+/// Lua wrapper for subscribe.  Arguments are property reference, callback,
+/// optional epsilon and optional type name.  Returns subscription ID
+static int luaSubscribeProp(lua_State *L)
+{
+    SaslPropRef prop = (SaslPropRef)lua_touserdata(L, 1);
+    if ((! prop) || (! lua_isfunction(L, 2))) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    double epsilon = lua_tonumber(L, 3);
+    const char *type = lua_tostring(L, 4);
+    bool isString = type && (! strcmp(type, "string"));
+    Luna &lua = getAvionics(L)->getLuna();
+    lua_pushvalue(L, 2);
+    int callback = lua.addRef();
+
+    lua_pushnumber(L, getAvionics(L)->getProps().subscribe(prop, epsilon, 
+                callback, isString));
+    return 1;
+}
+
+
+/// Lua wrapper for setPropPush.  Arguments are property reference,
+/// rate, deadband and optional relative flag.  Returns true on success
+static int luaSetPropPush(lua_State *L)
+{
+    SaslPropRef prop = (SaslPropRef)lua_touserdata(L, 1);
+    bool relative = lua_toboolean(L, 4);
+    lua_pushboolean(L, ! getAvionics(L)->getProps().setPropPush(prop, 
+                lua_tonumber(L, 2), lua_tonumber(L, 3), relative));
+    return 1;
+}
+
+
+/// Lua wrapper for unsubscribe
+static int luaUnsubscribeProp(lua_State *L)
+{
+    if (lua_isnumber(L, 1))
+        getAvionics(L)->getProps().unsubscribe((int)lua_tonumber(L, 1));
+    return 0;
+}
+
+
+/// Returns list of tables with counters of func props calls.
+/// Each table contains property name, number of reads, number of getter
+/// calls and number of setter calls
+static int luaGetFuncPropsStats(lua_State *L)
+{
+    const std::list<Properties::FuncPropHandler> &funcProps = 
+        getAvionics(L)->getProps().getFuncProps();
+
+    lua_createtable(L, funcProps.size(), 0);
+    int n = 1;
+    for (std::list<Properties::FuncPropHandler>::const_iterator i = 
+            funcProps.begin(); i != funcProps.end(); i++, n++)
+    {
+        const Properties::FuncPropHandler &h = *i;
+        lua_createtable(L, 0, 4);
+        lua_pushstring(L, h.name.c_str());
+        lua_setfield(L, -2, "name");
+        lua_pushnumber(L, h.reads);
+        lua_setfield(L, -2, "reads");
+        lua_pushnumber(L, h.getterCalls);
+        lua_setfield(L, -2, "getterCalls");
+        lua_pushnumber(L, h.setterCalls);
+        lua_setfield(L, -2, "setterCalls");
+        lua_rawseti(L, -2, n);
+    }
+
+    return 1;
+}
+
+
+/// Reset counters of func props calls
+static int luaResetFuncPropsStats(lua_State *L)
+{
+    getAvionics(L)->getProps().resetFuncPropsStats();
+    return 0;
+}
+
+
+/// Enable or disable queuing of property writes until end of frame
+static int luaSetPropsWriteBehind(lua_State *L)
+{
+    getAvionics(L)->getProps().setWriteBehind(lua_toboolean(L, 1));
+    return 0;
+}
+
+
+/// Pass queued property writes to simulator immediately
+static int luaFlushProps(lua_State *L)
+{
+    getAvionics(L)->getProps().flush();
+    return 0;
+}
+
 
 void xa::exportPropsToLua(Luna &lua)
 {
@@ -262,6 +459,17 @@ void xa::exportPropsToLua(Luna &lua)
     lua_register(L, "setPropd", luaSetPropd);
     lua_register(L, "getProps", luaGetProps);
     lua_register(L, "setProps", luaSetProps);
+    lua_register(L, "getPropArrayi", getPropArray<int>);
+    lua_register(L, "setPropArrayi", setPropArray<int>);
+    lua_register(L, "getPropArrayf", getPropArray<float>);
+    lua_register(L, "setPropArrayf", setPropArray<float>);
+    lua_register(L, "setPropsWriteBehind", luaSetPropsWriteBehind);
+    lua_register(L, "flushProps", luaFlushProps);
+    lua_register(L, "getFuncPropsStats", luaGetFuncPropsStats);
+    lua_register(L, "subscribeProp", luaSubscribeProp);
+    lua_register(L, "unsubscribeProp", luaUnsubscribeProp);
+    lua_register(L, "resetFuncPropsStats", luaResetFuncPropsStats);
+    lua_register(L, "setPropPush", luaSetPropPush);
 }
 
 
@@ -269,11 +477,20 @@ Properties::Properties(Luna &lua): lua(lua)
 {
     propsCallbacks = NULL;
     props = NULL;
+    writeBehind = false;
+    frame = 0;
+    nextSubscriptionId = 1;
+    subscriptionsChanged = false;
+    changesTable = LUA_NOREF;
 }
 
 
 Properties::~Properties()
 {
+    clearSubscriptions();
+    clearStringValues();
+    lua.unRef(changesTable);
+
     if (propsCallbacks && propsCallbacks->props_done)
         propsCallbacks->props_done(props);
 
@@ -292,6 +509,9 @@ void Properties::setProps(struct SaslPropsCallbacks *callbacks, SaslProps p)
     if (propsCallbacks && propsCallbacks->props_done)
         propsCallbacks->props_done(props);
 
+    pendingWrites.clear();
+    clearSubscriptions();
+    clearStringValues();
     propsCallbacks = callbacks;
     props = p;
 }
@@ -302,7 +522,10 @@ SaslPropRef Properties::getProp(const std::string &name, int type)
     if (! (propsCallbacks && props))
         return NULL;
 
-    return propsCallbacks->get_prop_ref(props, name.c_str(), type);
+    SaslPropRef prop = propsCallbacks->get_prop_ref(props, name.c_str(), type);
+    if (prop)
+        stats.setName(prop, name);
+    return prop;
 }
 
 
@@ -311,7 +534,11 @@ SaslPropRef Properties::createProp(const std::string &name, int type, int maxSiz
     if (! (propsCallbacks && props))
         return NULL;
 
-    return propsCallbacks->create_prop(props, name.c_str(), type, maxSize);
+    SaslPropRef prop = propsCallbacks->create_prop(props, name.c_str(), 
+            type, maxSize);
+    if (prop)
+        stats.setName(prop, name);
+    return prop;
 }
 
 
@@ -320,6 +547,20 @@ void Properties::freeProp(SaslPropRef prop)
     if ((! prop) || (! propsCallbacks))
         return;
 
+    PendingWrites::iterator i = pendingWrites.find(prop);
+    if (i != pendingWrites.end()) {
+        if (props)
+            write(prop, (*i).second);
+        pendingWrites.erase(i);
+    }
+
+    StringValues::iterator j = stringValues.find(prop);
+    if (j != stringValues.end()) {
+        if (LUA_NOREF != (*j).second.luaRef)
+            lua.unRef((*j).second.luaRef);
+        stringValues.erase(j);
+    }
+
     propsCallbacks->free_prop_ref(prop);
 }
 
@@ -340,6 +581,14 @@ int Properties::getPropi(SaslPropRef prop, int dflt, int *err)
         return dflt;
     }
 
+    PropsStats::Read read(stats, prop);
+
+    if (! pendingWrites.empty()) {
+        const PendingWrite *w = findPendingWrite(prop);
+        if (w && (PROP_STRING != w->type))
+            return (int)w->number;
+    }
+
     int res = propsCallbacks->get_prop_int(prop, err);
     if (*err)
         res = dflt;
@@ -355,6 +604,13 @@ int Properties::setProp(SaslPropRef prop, int value)
     if (! (propsCallbacks && props))
         return 0;
 
+    PropsStats::Write write(stats, prop, value);
+
+    if (writeBehind) {
+        queueWrite(prop, PROP_INT, value);
+        return 0;
+    }
+
     return propsCallbacks->set_prop_int(prop, value);
 }
 
@@ -376,6 +632,14 @@ float Properties::getPropf(SaslPropRef prop, float dflt, int *err)
         return dflt;
     }
 
+    PropsStats::Read read(stats, prop);
+
+    if (! pendingWrites.empty()) {
+        const PendingWrite *w = findPendingWrite(prop);
+        if (w && (PROP_STRING != w->type))
+            return (float)w->number;
+    }
+
     float res = propsCallbacks->get_prop_float(prop, err);
     if (*err)
         res = dflt;
@@ -391,10 +655,17 @@ int Properties::setProp(SaslPropRef prop, float value)
     if (! (propsCallbacks && props))
             return 0;
 
+    PropsStats::Write write(stats, prop, value);
+
+    if (writeBehind) {
+        queueWrite(prop, PROP_FLOAT, value);
+        return 0;
+    }
+
     return propsCallbacks->set_prop_float(prop, value);
 }
 
-float Properties::getPropd(SaslPropRef prop, double dflt, int *err)
+double Properties::getPropd(SaslPropRef prop, double dflt, int *err)
 {
     int localErr;
     if (! err)
@@ -411,6 +682,14 @@ float Properties::getPropd(SaslPropRef prop, double dflt, int *err)
         return dflt;
     }
 
+    PropsStats::Read read(stats, prop);
+
+    if (! pendingWrites.empty()) {
+        const PendingWrite *w = findPendingWrite(prop);
+        if (w && (PROP_STRING != w->type))
+            return w->number;
+    }
+
     double res = propsCallbacks->get_prop_double(prop, err);
     if (*err)
         res = dflt;
@@ -426,6 +705,13 @@ int Properties::setProp(SaslPropRef prop, double value)
     if (! (propsCallbacks && props))
         return 0;
 
+    PropsStats::Write write(stats, prop, value);
+
+    if (writeBehind) {
+        queueWrite(prop, PROP_DOUBLE, value);
+        return 0;
+    }
+
     return propsCallbacks->set_prop_double(prop, value);
 }
 
@@ -446,16 +732,93 @@ std::string Properties::getProps(SaslPropRef prop, const std::string &dflt,
         return dflt;
     }
 
-    int sz = propsCallbacks->get_prop_string(prop, NULL, 0, err);
-#ifdef WINDOWS
-    char *buf = (char*)alloca(sz + 1);
-#else
-    char buf[sz + 1];
-#endif
-    propsCallbacks->get_prop_string(prop, buf, sz, err);
+    PropsStats::Read read(stats, prop);
+
+    if (! pendingWrites.empty()) {
+        const PendingWrite *w = findPendingWrite(prop);
+        if (w && (PROP_STRING == w->type))
+            return w->string;
+    }
+
+    int len = readString(prop, err);
     if (*err)
         return dflt;
-    return buf;
+    return std::string(&stringBuffer[0], len);
+}
+
+
+void Properties::pushPropString(SaslPropRef prop, const char *dflt)
+{
+    lua_State *L = lua.getLua();
+
+    if ((! prop) || (! (propsCallbacks && props))) {
+        lua_pushstring(L, dflt);
+        return;
+    }
+
+    PropsStats::Read read(stats, prop);
+
+    if (! pendingWrites.empty()) {
+        const PendingWrite *w = findPendingWrite(prop);
+        if (w && (PROP_STRING == w->type)) {
+            lua_pushlstring(L, w->string.c_str(), w->string.length());
+            return;
+        }
+    }
+
+    int err = 0;
+    int len = readString(prop, &err);
+    if (err) {
+        lua_pushstring(L, dflt);
+        return;
+    }
+
+    StringValue &value = stringValues[prop];
+    if ((LUA_NOREF != value.luaRef) && (len == (int)value.bytes.size()) &&
+            ((! len) || (! memcmp(&value.bytes[0], &stringBuffer[0], len))))
+    {
+        lua.getRef(value.luaRef);
+        return;
+    }
+
+    value.bytes.assign(stringBuffer.begin(), stringBuffer.begin() + len);
+    lua_pushlstring(L, &stringBuffer[0], len);
+    if (LUA_NOREF != value.luaRef)
+        lua.unRef(value.luaRef);
+    lua_pushvalue(L, -1);
+    value.luaRef = lua.addRef();
+}
+
+
+int Properties::readString(SaslPropRef prop, int *err)
+{
+    if (stringBuffer.size() < 64)
+        stringBuffer.resize(64);
+
+    int sz = propsCallbacks->get_prop_string(prop, &stringBuffer[0], 
+            stringBuffer.size(), err);
+    if (sz >= (int)stringBuffer.size()) {
+        // buffer is too small, read again
+        stringBuffer.resize(sz + 1);
+        *err = 0;
+        propsCallbacks->get_prop_string(prop, &stringBuffer[0], 
+                stringBuffer.size(), err);
+    }
+    if (*err)
+        return 0;
+
+    stringBuffer[stringBuffer.size() - 1] = 0;
+    return strlen(&stringBuffer[0]);
+}
+
+
+void Properties::clearStringValues()
+{
+    for (StringValues::iterator i = stringValues.begin(); 
+            i != stringValues.end(); i++)
+        if (LUA_NOREF != (*i).second.luaRef)
+            lua.unRef((*i).second.luaRef);
+    stringValues.clear();
 }
 
 
@@ -464,69 +827,421 @@ int Properties::setProp(SaslPropRef prop, const std::string &value)
     if ((! prop) || (! (propsCallbacks && props)))
         return 0;
     
+    PropsStats::Write write(stats, prop, value);
+
+    if (writeBehind) {
+        queueWrite(prop, PROP_STRING, 0, value);
+        return 0;
+    }
+
     return propsCallbacks->set_prop_string(prop, value.c_str());
 }
 
 
+int Properties::getPropArray(SaslPropRef prop, int offset, int count, 
+        int *values)
+{
+    if ((! prop) || (! (propsCallbacks && props)) || 
+            (! propsCallbacks->get_prop_array_int))
+        return -1;
+
+    // array elements could be written through other references
+    if (! pendingWrites.empty())
+        flush();
+
+    PropsStats::Read read(stats, prop);
+    return propsCallbacks->get_prop_array_int(prop, offset, count, values);
+}
+
+
+int Properties::setPropArray(SaslPropRef prop, int offset, int count, 
+        const int *values)
+{
+    if ((! prop) || (! (propsCallbacks && props)) || 
+            (! propsCallbacks->set_prop_array_int))
+        return -1;
+
+    // array elements could be written through other references
+    if (! pendingWrites.empty())
+        flush();
+
+    PropsStats::Write write(stats, prop);
+    return propsCallbacks->set_prop_array_int(prop, offset, count, values);
+}
+
+
+int Properties::getPropArray(SaslPropRef prop, int offset, int count, 
+        float *values)
+{
+    if ((! prop) || (! (propsCallbacks && props)) || 
+            (! propsCallbacks->get_prop_array_float))
+        return -1;
+
+    // array elements could be written through other references
+    if (! pendingWrites.empty())
+        flush();
+
+    PropsStats::Read read(stats, prop);
+    return propsCallbacks->get_prop_array_float(prop, offset, count, values);
+}
+
+
+int Properties::setPropArray(SaslPropRef prop, int offset, int count, 
+        const float *values)
+{
+    if ((! prop) || (! (propsCallbacks && props)) || 
+            (! propsCallbacks->set_prop_array_float))
+        return -1;
+
+    // array elements could be written through other references
+    if (! pendingWrites.empty())
+        flush();
+
+    PropsStats::Write write(stats, prop);
+    return propsCallbacks->set_prop_array_float(prop, offset, count, values);
+}
+
+
+int Properties::getPropGroup(const SaslPropRef *refs, int count, 
+        double *values)
+{
+    if (! (propsCallbacks && props)) {
+        for (int i = 0; i < count; i++)
+            values[i] = 0;
+        return count;
+    }
+
+    double start = stats.getStartTime();
+    int failed = 0;
+    if (propsCallbacks->get_props_double)
+        failed = propsCallbacks->get_props_double(refs, count, values);
+    else
+        for (int i = 0; i < count; i++) {
+            int err = 0;
+            values[i] = refs[i] ? 
+                propsCallbacks->get_prop_double(refs[i], &err) : 0;
+            if ((! refs[i]) || err) {
+                values[i] = 0;
+                failed++;
+            }
+        }
+
+    if (! pendingWrites.empty())
+        for (int i = 0; i < count; i++) {
+            const PendingWrite *w = findPendingWrite(refs[i]);
+            if (w && (PROP_STRING != w->type))
+                values[i] = w->number;
+        }
+
+    stats.addReads(refs, count, start);
+    return failed;
+}
+
+
 int Properties::update()
 {
     if (! (propsCallbacks && props))
         return 0;
 
+    flush();
+    frame++;
+
     int err = 0;
     if (propsCallbacks->update_props)
         err = propsCallbacks->update_props(props);
 
+    if (! subscriptions.empty())
+        notifySubscribers();
+
     return err;
 }
 
 
+int Properties::subscribe(SaslPropRef prop, double epsilon, int callback,
+        bool isString)
+{
+    int id = nextSubscriptionId++;
+    Subscription &s = subscriptions[id];
+    s.prop = prop;
+    s.epsilon = epsilon;
+    s.value = 0;
+    s.isString = isString;
+    s.notified = false;
+    s.callback = callback;
+    subscriptionsChanged = true;
+    return id;
+}
+
+
+int Properties::setPropPush(SaslPropRef prop, double rate, 
+        double deadband, bool relative)
+{
+    if ((! prop) || (! (propsCallbacks && props)) || 
+            (! propsCallbacks->set_prop_push))
+        return -1;
+    return propsCallbacks->set_prop_push(prop, rate, deadband, relative);
+}
+
+
+void Properties::unsubscribe(int id)
+{
+    Subscriptions::iterator i = subscriptions.find(id);
+    if (i == subscriptions.end())
+        return;
+
+    lua.unRef((*i).second.callback);
+    subscriptions.erase(i);
+    subscriptionsChanged = true;
+}
+
+
+void Properties::clearSubscriptions()
+{
+    for (Subscriptions::iterator i = subscriptions.begin(); 
+            i != subscriptions.end(); i++)
+        lua.unRef((*i).second.callback);
+    subscriptions.clear();
+    subscriptionsChanged = true;
+}
+
+
+void Properties::notifySubscribers()
+{
+    if (subscriptionsChanged) {
+        subscribedRefs.clear();
+        subscribedIds.clear();
+        subscribedStrings.clear();
+        for (Subscriptions::iterator i = subscriptions.begin(); 
+                i != subscriptions.end(); i++)
+        {
+            if ((*i).second.isString)
+                subscribedStrings.push_back((*i).first);
+            else {
+                subscribedRefs.push_back((*i).second.prop);
+                subscribedIds.push_back((*i).first);
+            }
+        }
+        subscribedValues.resize(subscribedRefs.size());
+        subscriptionsChanged = false;
+    }
+
+    if (! subscribedRefs.empty())
+        getPropGroup(&subscribedRefs[0], subscribedRefs.size(), 
+                &subscribedValues[0]);
+
+    // collect all changes first, callbacks could modify subscriptions
+    changedIds.clear();
+    for (unsigned i = 0; i < subscribedIds.size(); i++) {
+        Subscription &s = subscriptions[subscribedIds[i]];
+        double value = subscribedValues[i];
+        // NaN is not equal to itself
+        bool bothNaN = (value != value) && (s.value != s.value);
+        if (s.notified && (bothNaN || (fabs(value - s.value) <= s.epsilon)))
+            continue;
+        s.value = value;
+        s.notified = true;
+        changedIds.push_back(subscribedIds[i]);
+    }
+
+    // strings can't be read by group read
+    for (unsigned i = 0; i < subscribedStrings.size(); i++) {
+        Subscription &s = subscriptions[subscribedStrings[i]];
+        int err = 0;
+        std::string value = getProps(s.prop, "", &err);
+        if (s.notified && (value == s.string))
+            continue;
+        s.string = value;
+        s.notified = true;
+        changedIds.push_back(subscribedStrings[i]);
+    }
+
+    if (changedIds.empty())
+        return;
+
+    // changes are passed to Lua as list of ID, callback and value triples
+    lua_State *L = lua.getLua();
+    lua_getglobal(L, "notifyPropertyListeners");
+    if (LUA_NOREF == changesTable) {
+        lua_newtable(L);
+        changesTable = lua.addRef();
+    }
+    lua.getRef(changesTable);
+    int count = 0;
+    for (unsigned i = 0; i < changedIds.size(); i++) {
+        const Subscription &s = subscriptions[changedIds[i]];
+        lua_pushnumber(L, changedIds[i]);
+        lua_rawseti(L, -2, count * 3 + 1);
+        lua.getRef(s.callback);
+        lua_rawseti(L, -2, count * 3 + 2);
+        if (s.isString)
+            lua_pushlstring(L, s.string.data(), s.string.length());
+        else
+            lua_pushnumber(L, s.value);
+        lua_rawseti(L, -2, count * 3 + 3);
+        count++;
+    }
+    lua_pushnumber(L, count);
+    if (lua_pcall(L, 2, 0, 0)) {
+        getAvionics(L)->getLog().error(
+                "Error calling property change callbacks: %s\n", 
+                lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+}
+
+
+void Properties::setWriteBehind(bool enable)
+{
+    if (! enable)
+        flush();
+    writeBehind = enable;
+}
+
+
+void Properties::flush()
+{
+    if (pendingWrites.empty())
+        return;
+
+    if (propsCallbacks && props)
+        for (PendingWrites::iterator i = pendingWrites.begin(); 
+                i != pendingWrites.end(); i++)
+            write((*i).first, (*i).second);
+
+    pendingWrites.clear();
+}
+
+
+const Properties::PendingWrite* Properties::findPendingWrite(
+        SaslPropRef prop) const
+{
+    PendingWrites::const_iterator i = pendingWrites.find(prop);
+    if (i == pendingWrites.end())
+        return NULL;
+    else
+        return &(*i).second;
+}
+
+
+void Properties::queueWrite(SaslPropRef prop, int type, double number, 
+        const std::string &string)
+{
+    PendingWrite &w = pendingWrites[prop];
+    w.type = type;
+    w.number = number;
+    w.string = string;
+}
+
+
+int Properties::write(SaslPropRef prop, const PendingWrite &value)
+{
+    switch (value.type) {
+        case PROP_INT: 
+            return propsCallbacks->set_prop_int(prop, (int)value.number);
+        case PROP_FLOAT: 
+            return propsCallbacks->set_prop_float(prop, (float)value.number);
+        case PROP_DOUBLE: 
+            return propsCallbacks->set_prop_double(prop, value.number);
+        case PROP_STRING: 
+            return propsCallbacks->set_prop_string(prop, 
+                    value.string.c_str());
+    }
+    return -1;
+}
+
+
+/// Returns true if cached value of func prop could be used
+static bool isCacheValid(Properties::FuncPropHandler *handler)
+{
+    if (! handler->cached)
+        return false;
+
+    switch (handler->cache) {
+        case Properties::CACHE_FRAME: 
+            return handler->cachedAt == handler->properties->getFrame();
+        case Properties::CACHE_TIME: 
+            return handler->properties->getTime() - handler->cachedAt < 
+                handler->cacheTime;
+        case Properties::CACHE_UNTIL_SET: 
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/// Copy cached value of func prop into buffer.
+/// Returns size of value
+static int copyCachedValue(Properties::FuncPropHandler *handler, int type, 
+        void *buf, int maxSize)
+{
+    switch (type) {
+        case PROP_INT: {
+                int v = (int)handler->cachedNumber;
+                if (buf && (maxSize >= (int)sizeof(v)))
+                    memcpy(buf, &v, sizeof(v));
+                return sizeof(v);
+            }
+        case PROP_FLOAT: {
+                float v = (float)handler->cachedNumber;
+                if (buf && (maxSize >= (int)sizeof(v)))
+                    memcpy(buf, &v, sizeof(v));
+                return sizeof(v);
+            }
+        case PROP_DOUBLE: {
+                double v = handler->cachedNumber;
+                if (buf && (maxSize >= (int)sizeof(v)))
+                    memcpy(buf, &v, sizeof(v));
+                return sizeof(v);
+            }
+        case PROP_STRING: {
+                int len = handler->cachedString.length();
+                if (buf && (maxSize > len))
+                    memcpy(buf, handler->cachedString.c_str(), len + 1);
+                return len + 1;
+            }
+    }
+    return 0;
+}
+
+
 static int propGetterCallback(int type, void *buf, int maxSize, void *ref)
 {
     Properties::FuncPropHandler *handler = (Properties::FuncPropHandler*)ref;
     if (! handler)
         return 0;
 
+    handler->reads++;
+    if (isCacheValid(handler))
+        return copyCachedValue(handler, type, buf, maxSize);
+
     Luna &lua = handler->properties->getLua();
     lua_State *L = lua.getLua();
     
     lua.getRef(handler->getter);
+    handler->getterCalls++;
     
-    if (lua_pcall(L, 0, 1, 0))
+    if (lua_pcall(L, 0, 1, 0)) {
         getAvionics(L)->getLog().error(
                 "Error calling property getter: %s\n", lua_tostring(L, -1));
-    else {
-        switch (type) {
-            case PROP_INT: {
-                    int v = lua_tointeger(L, -1);
-                    if (buf && (maxSize >= (int)sizeof(v)))
-                        memcpy(buf, &v, sizeof(v));
-                    return sizeof(v);
-                }
-            case PROP_FLOAT: {
-                    float v = (float)lua_tonumber(L, -1);
-                    if (buf && (maxSize >= (int)sizeof(v)))
-                        memcpy(buf, &v, sizeof(v));
-                    return sizeof(v);
-                }
-            case PROP_DOUBLE: {
-                    double v = lua_tonumber(L, -1);
-                    if (buf && (maxSize >= (int)sizeof(v)))
-                        memcpy(buf, &v, sizeof(v));
-                    return sizeof(v);
-                }
-            case PROP_STRING: {
-                    const char *v = lua_tostring(L, -1);
-                    int len = strlen(v);
-                    if (buf && (maxSize >= (int)len))
-                        memcpy(buf, v, len + 1);
-                    return len + 1;
-                }
-        }
         lua_pop(L, 1);
+        return 0;
     }
 
-    return 0;
+    if (PROP_STRING == type) {
+        const char *v = lua_tostring(L, -1);
+        handler->cachedString = v ? v : "";
+    } else
+        handler->cachedNumber = lua_tonumber(L, -1);
+    lua_pop(L, 1);
+
+    handler->cached = true;
+    if (Properties::CACHE_TIME == handler->cache)
+        handler->cachedAt = handler->properties->getTime();
+    else
+        handler->cachedAt = handler->properties->getFrame();
+
+    return copyCachedValue(handler, type, buf, maxSize);
 }
 
 
@@ -536,6 +1251,9 @@ static void propSetterCallback(int type, void *buf, int size, void *ref)
     if ((! handler) || (! buf))
         return;
 
+    handler->setterCalls++;
+    handler->cached = false;
+
     Luna &lua = handler->properties->getLua();
     lua_State *L = lua.getLua();
     lua.getRef(handler->setter);
@@ -561,21 +1279,43 @@ static void propSetterCallback(int type, void *buf, int size, void *ref)
 }
 
 SaslPropRef Properties::registerFuncProp(const std::string &name, int type, 
-        int maxSize, int getter, int setter)
+        int maxSize, int getter, int setter, FuncPropCache cache, 
+        long cacheTime)
 {
     if (! (propsCallbacks && props))
         return 0;
 
     FuncPropHandler handler;
     handler.properties = this;
+    handler.name = name;
     handler.getter = getter;
     handler.setter = setter;
+    handler.cache = cache;
+    handler.cacheTime = cacheTime;
+    handler.cached = false;
+    handler.cachedAt = 0;
+    handler.cachedNumber = 0;
+    handler.reads = handler.getterCalls = handler.setterCalls = 0;
 
     funcProps.push_back(handler);
 
-    return propsCallbacks->create_func_prop(props, name.c_str(),
+    SaslPropRef prop = propsCallbacks->create_func_prop(props, name.c_str(),
             type, maxSize, propGetterCallback, propSetterCallback, 
             &(funcProps.back()));
+    if (prop)
+        stats.setName(prop, name);
+    return prop;
+}
+
+
+void Properties::resetFuncPropsStats()
+{
+    for (std::list<FuncPropHandler>::iterator i = funcProps.begin(); 
+            i != funcProps.end(); i++)
+    {
+        FuncPropHandler &h = *i;
+        h.reads = h.getterCalls = h.setterCalls = 0;
+    }
 }
 
 
@@ -5,8 +5,12 @@
 #include "libavcallbacks.h"
 #include <string>
 #include <list>
+#include <map>
+#include <vector>
 #include "luna.h"
 #include "log.h"
+#include "rttimer.h"
+#include "propsstats.h"
 
 
 namespace xa {
@@ -26,22 +30,172 @@ class Properties
         SaslProps props;
 
     public:
+        /// Caching policy of functional properties values
+        enum FuncPropCache {
+            /// Getter is called on every read
+            CACHE_NONE,
+
+            /// Getter is called once per frame
+            CACHE_FRAME,
+
+            /// Getter is called once per specified number of milliseconds
+            CACHE_TIME,
+
+            /// Getter is called on first read after setter
+            CACHE_UNTIL_SET
+        };
+
         /// stpres references to property callbacks
         struct FuncPropHandler{
             /// reference to properties
             Properties *properties;
 
+            /// Name of property
+            std::string name;
+
             /// Lua reference to getter func
             int getter;
 
             /// Lua reference to setter func
             int setter;
+
+            /// Caching policy
+            FuncPropCache cache;
+
+            /// Time to keep cached value for CACHE_TIME policy
+            long cacheTime;
+
+            /// True if cached value was set
+            bool cached;
+
+            /// Frame or time when value was cached
+            long cachedAt;
+
+            /// Cached value of numeric property
+            double cachedNumber;
+
+            /// Cached value of string property
+            std::string cachedString;
+
+            /// Number of reads of property
+            long reads;
+
+            /// Number of getter calls
+            long getterCalls;
+
+            /// Number of setter calls
+            long setterCalls;
         };
 
     private:
         /// list of registered func props
         std::list<FuncPropHandler> funcProps;
 
+        /// Number of current frame
+        long frame;
+
+        /// Timer used to expire cached values of func props
+        RtTimer timer;
+
+        /// Subscription to changes of property value
+        struct Subscription {
+            /// Reference to property
+            SaslPropRef prop;
+
+            /// Minimal change of value passed to callback
+            double epsilon;
+
+            /// Value passed to callback last time
+            double value;
+
+            /// True if property is compared as string
+            bool isString;
+
+            /// String passed to callback last time
+            std::string string;
+
+            /// True if callback was called at least once
+            bool notified;
+
+            /// Lua reference to callback function
+            int callback;
+        };
+
+        /// Subscriptions mapped by ID
+        typedef std::map<int, Subscription> Subscriptions;
+
+        /// All subscriptions
+        Subscriptions subscriptions;
+
+        /// ID of next subscription
+        int nextSubscriptionId;
+
+        /// True if subscriptions were changed since last update
+        bool subscriptionsChanged;
+
+        /// References to subscribed properties to read them at once
+        std::vector<SaslPropRef> subscribedRefs;
+
+        /// IDs of subscriptions in the same order as subscribedRefs
+        std::vector<int> subscribedIds;
+
+        /// IDs of subscriptions to string properties
+        std::vector<int> subscribedStrings;
+
+        /// Values of subscribed properties read in current frame
+        std::vector<double> subscribedValues;
+
+        /// IDs of subscriptions changed in current frame
+        std::vector<int> changedIds;
+
+        /// Lua reference to table of changes passed to Lua or LUA_NOREF
+        int changesTable;
+
+        /// Last value of string property passed to Lua
+        struct StringValue {
+            /// Bytes of string
+            std::vector<char> bytes;
+
+            /// Lua reference to string or LUA_NOREF
+            int luaRef;
+
+            StringValue(): luaRef(LUA_NOREF) { };
+        };
+
+        /// Values of string properties mapped by reference
+        typedef std::map<SaslPropRef, StringValue> StringValues;
+
+        /// Last values of string properties read by Lua
+        StringValues stringValues;
+
+        /// Buffer for reading string properties
+        std::vector<char> stringBuffer;
+
+        /// Counters of properties access
+        PropsStats stats;
+
+        /// Value written to property but not passed to callbacks yet
+        struct PendingWrite {
+            /// Type of written value
+            int type;
+
+            /// Value of numeric property
+            double number;
+
+            /// Value of string property
+            std::string string;
+        };
+
+        /// Pending writes mapped by property reference
+        typedef std::map<SaslPropRef, PendingWrite> PendingWrites;
+
+        /// If true writes are queued until end of frame
+        bool writeBehind;
+
+        /// Writes queued in current frame.  Only last value written to
+        /// property is stored
+        PendingWrites pendingWrites;
+
     public:
         Properties(Luna &lua);
 
@@ -78,7 +232,7 @@ class Properties
         
         /// Returns value of property as double
         /// On errors returns dflt
-        float getPropd(SaslPropRef prop, double dflt=0, int *err=NULL);
+        double getPropd(SaslPropRef prop, double dflt=0, int *err=NULL);
         
         /// Set value of double property.
         int setProp(SaslPropRef prop, double value);
@@ -90,18 +244,127 @@ class Properties
         /// Set value of string property.
         int setProp(SaslPropRef prop, const std::string &value);
 
-        /// Update properties subsystem
+        /// Push value of string property to Lua stack.  If value wasn't
+        /// changed since last call the same Lua string is pushed.
+        /// On errors pushes dflt
+        void pushPropString(SaslPropRef prop, const char *dflt);
+
+        /// Read elements of array property as integers.
+        /// Returns number of elements read or -1 on error
+        int getPropArray(SaslPropRef prop, int offset, int count, 
+                int *values);
+
+        /// Write elements of array property as integers.
+        int setPropArray(SaslPropRef prop, int offset, int count, 
+                const int *values);
+
+        /// Read elements of array property as floats.
+        /// Returns number of elements read or -1 on error
+        int getPropArray(SaslPropRef prop, int offset, int count, 
+                float *values);
+
+        /// Write elements of array property as floats.
+        int setPropArray(SaslPropRef prop, int offset, int count, 
+                const float *values);
+
+        /// Read values of several properties as doubles in single call.
+        /// Values of properties which can't be read are set to zero.
+        /// Returns number of properties failed to read
+        int getPropGroup(const SaslPropRef *refs, int count, double *values);
+
+        /// Ask networked properties server to push changes of property.
+        /// Returns non-zero if properties source doesn't support it
+        /// \param prop property reference.
+        /// \param rate maximum number of updates per second, 0 disables push.
+        /// \param deadband minimum change of value to send.
+        /// \param relative if true deadband is fraction of last value.
+        int setPropPush(SaslPropRef prop, double rate, double deadband,
+                bool relative);
+
+        /// Update properties subsystem.  Flushes pending writes first
+        /// and notifies subscribers about changed properties after update
         int update();
 
+        /// Call Lua function when value of property changes.
+        /// Callback is called from update with new value of property as
+        /// argument.  Returns ID of subscription
+        /// \param prop property reference.
+        /// \param epsilon minimal change of value passed to callback.
+        /// \param callback Lua reference to callback function.  It will be
+        ///     unreferenced on unsubscribe.
+        /// \param isString true if property is string property.
+        int subscribe(SaslPropRef prop, double epsilon, int callback,
+                bool isString);
+
+        /// Remove subscription
+        void unsubscribe(int id);
+
+        /// Enable or disable queuing of writes.  If enabled values
+        /// written to properties are stored until flush and only last
+        /// value written to each property is passed to properties
+        /// callbacks.  Reads return values written in current frame
+        void setWriteBehind(bool enable);
+
+        /// Returns true if writes are queued
+        bool isWriteBehind() const { return writeBehind; };
+
+        /// Pass queued writes to properties callbacks
+        void flush();
+
         /// register functional property
+        /// \param cache caching policy of property value.
+        /// \param cacheTime time in milliseconds to keep cached value 
+        ///     for CACHE_TIME policy.
         SaslPropRef registerFuncProp(const std::string &name, int type, 
-                int maxSize, int getter, int setter);
+                int maxSize, int getter, int setter, 
+                FuncPropCache cache=CACHE_NONE, long cacheTime=0);
+
+        /// Returns list of registered func props
+        const std::list<FuncPropHandler>& getFuncProps() const { 
+            return funcProps; };
+
+        /// Reset counters of func props calls
+        void resetFuncPropsStats();
+
+        /// Returns number of current frame
+        long getFrame() const { return frame; };
+
+        /// Returns time in milliseconds
+        long getTime() { return timer.getTime(); };
        
         /// remove property handler from list and unref callbacks
         void destroyFuncProp(FuncPropHandler *handler);
 
         /// Returns Lua wrapper
         Luna& getLua() { return lua; };
+
+        /// Returns counters of properties access
+        PropsStats& getStats() { return stats; };
+
+    private:
+        /// Returns pending write to property or NULL if there is no one
+        const PendingWrite* findPendingWrite(SaslPropRef prop) const;
+
+        /// Store write to property until flush
+        void queueWrite(SaslPropRef prop, int type, double number, 
+                const std::string &string=std::string());
+
+        /// Pass single write to properties callbacks
+        int write(SaslPropRef prop, const PendingWrite &value);
+
+        /// Read values of subscribed properties and pass callbacks of
+        /// changed ones to Lua notifyPropertyListeners in single call
+        void notifySubscribers();
+
+        /// Remove all subscriptions
+        void clearSubscriptions();
+
+        /// Read value of string property into stringBuffer.
+        /// Returns length of string
+        int readString(SaslPropRef prop, int *err);
+
+        /// Forget last values of string properties
+        void clearStringValues();
 };
 
 
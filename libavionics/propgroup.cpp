@@ -0,0 +1,144 @@
+#include "propgroup.h"
+
+#include <new>
+#include "avionics.h"
+
+
+using namespace xa;
+
+
+/// Name of Lua metatable of property group objects
+#define PROP_GROUP_META "xa.PropGroup"
+
+
+
+int PropGroup::add(SaslPropRef ref)
+{
+    refs.push_back(ref);
+    values.push_back(0);
+    return refs.size();
+}
+
+
+int PropGroup::read(Properties &properties)
+{
+    if (refs.empty())
+        return 0;
+    return properties.getPropGroup(&refs[0], refs.size(), &values[0]);
+}
+
+
+
+/// Returns property group stored in Lua stack
+static PropGroup* getPropGroup(lua_State *L, int idx)
+{
+    return (PropGroup*)luaL_checkudata(L, idx, PROP_GROUP_META);
+}
+
+
+/// Returns reference to property described by Lua value.
+/// Value could be property reference, property table with ref field
+/// or name of property.  Returns NULL if property not found
+static SaslPropRef toPropRef(lua_State *L, int idx)
+{
+    if (lua_islightuserdata(L, idx))
+        return lua_touserdata(L, idx);
+
+    if (lua_istable(L, idx)) {
+        lua_getfield(L, idx, "ref");
+        SaslPropRef ref = lua_touserdata(L, -1);
+        lua_pop(L, 1);
+        return ref;
+    }
+
+    if (lua_type(L, idx) == LUA_TSTRING)
+        return getAvionics(L)->getProps().getProp(lua_tostring(L, idx), 
+                PROP_DOUBLE);
+
+    return NULL;
+}
+
+
+/// Add property passed as 2nd argument to group.
+/// Returns index of property in group
+static int luaPropGroupAdd(lua_State *L)
+{
+    PropGroup *group = getPropGroup(L, 1);
+    lua_pushnumber(L, group->add(toPropRef(L, 2)));
+    return 1;
+}
+
+
+/// Create new property group.
+/// Optional argument is list of properties to add to group
+static int luaCreatePropGroup(lua_State *L)
+{
+    void *data = lua_newuserdata(L, sizeof(PropGroup));
+    new (data) PropGroup();
+    luaL_getmetatable(L, PROP_GROUP_META);
+    lua_setmetatable(L, -2);
+
+    if (lua_istable(L, 1)) {
+        PropGroup *group = (PropGroup*)data;
+        int size = lua_objlen(L, 1);
+        for (int i = 1; i <= size; i++) {
+            lua_rawgeti(L, 1, i);
+            group->add(toPropRef(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+
+    return 1;
+}
+
+
+/// Destroy property group collected by Lua.
+/// Property references are not freed like references returned by findProp:
+/// properties subsystem could be already destroyed at this moment
+static int luaDestroyPropGroup(lua_State *L)
+{
+    PropGroup *group = getPropGroup(L, 1);
+    group->~PropGroup();
+    return 0;
+}
+
+
+/// Read values of all properties of group into table passed as 2nd
+/// argument or into new table.  Returns table and number of properties
+/// failed to read
+static int luaReadPropGroup(lua_State *L)
+{
+    PropGroup *group = getPropGroup(L, 1);
+    int failed = group->read(getAvionics(L)->getProps());
+
+    int size = group->getSize();
+    if (lua_istable(L, 2))
+        lua_pushvalue(L, 2);
+    else
+        lua_createtable(L, size, 0);
+
+    const double *values = group->getValues();
+    for (int i = 0; i < size; i++) {
+        lua_pushnumber(L, values[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    lua_pushnumber(L, failed);
+    return 2;
+}
+
+
+void xa::exportPropGroupToLua(Luna &lua)
+{
+    lua_State *L = lua.getLua();
+
+    luaL_newmetatable(L, PROP_GROUP_META);
+    lua_pushcfunction(L, luaDestroyPropGroup);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    lua_register(L, "createPropGroup", luaCreatePropGroup);
+    lua_register(L, "propGroupAdd", luaPropGroupAdd);
+    lua_register(L, "readPropGroup", luaReadPropGroup);
+}
+
@@ -0,0 +1,53 @@
+#ifndef __PROP_GROUP_H__
+#define __PROP_GROUP_H__
+
+
+#include <vector>
+#include "libavcallbacks.h"
+#include "luna.h"
+
+
+namespace xa {
+
+
+class Properties;
+
+
+/// Group of properties read together once per frame.
+/// Values are fetched with single properties callback instead of
+/// separate call for each property
+class PropGroup
+{
+    private:
+        /// References to properties in order of addition.
+        /// Could contain NULL for properties which weren't found
+        std::vector<SaslPropRef> refs;
+
+        /// Values read by last call to read
+        std::vector<double> values;
+
+    public:
+        /// Add property to group.  Returns index of property in group
+        int add(SaslPropRef ref);
+
+        /// Returns number of properties in group
+        int getSize() const { return refs.size(); };
+
+        /// Read values of all properties of group.
+        /// Returns number of properties failed to read
+        int read(Properties &properties);
+
+        /// Returns values read by last call to read
+        const double* getValues() const { return values.empty() ? 
+            NULL : &values[0]; };
+};
+
+
+/// Register property groups functions in Lua
+void exportPropGroupToLua(Luna &lua);
+
+};
+
+
+#endif
+
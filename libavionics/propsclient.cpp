@@ -17,6 +17,8 @@ using namespace xa;
 
 struct NetProps;
 
+static SaslPropRef getSaslPropRef(SaslProps props, const char *name, int type);
+
 
 /// Value of property
 class PropValue
@@ -38,15 +40,23 @@ class PropValue
             double doubleValue;
 
             char *buf;
-            int maxBufSize;
         } lastValue;
 
+        /// Size of buffer allocated for string value
+        int maxBufSize;
+
         /// Refernce to properties storage
         NetProps *props;
 
         /// Do not update till this revision
         int notUpdateTill;
 
+        /// True if server sent value of property
+        bool received;
+
+        /// Properties of array elements.  Created on first access
+        std::vector<PropValue*> elements;
+
     public:
         /// Create new property value
         PropValue(NetProps *props, int id, int type, const char *name);
@@ -66,6 +76,10 @@ class PropValue
         /// Returns reference to properties storage
         NetProps* getProps() { return props; }
 
+        /// Returns true if server sent value of property.
+        /// Server never sends values of properties it doesn't have
+        bool isReceived() const { return received; }
+
         /// Returns property value as integer
         int getInt(int *err);
 
@@ -93,6 +107,11 @@ class PropValue
         /// Load property value from raw data
         void parse(const unsigned char *data, int revision);
 
+        /// Returns property of array element or NULL on error.
+        /// Protocol doesn't support arrays, so each element is
+        /// requested as separate property "name[index]"
+        PropValue* getElement(int index);
+
     private:
         /// Send set property value command to server
         int sendPropUpdate();
@@ -109,7 +128,10 @@ struct NetProps
     uint16_t lastSetSerial;
     uint16_t curSetSerial;
 
-    NetProps(Log &log): log(log), con(log) { };
+    /// Protocol version accepted by server
+    int version;
+
+    NetProps(Log &log): log(log), con(log) { version = 2; };
 
     ~NetProps() {
         for (std::vector<PropValue*>::iterator i = values.begin();
@@ -121,11 +143,44 @@ struct NetProps
 
 
 
+/// Start new message in send buffer.  Returns position of message.
+/// Messages of protocol version 3 are prefixed with length
+static size_t beginMessage(NetProps *p)
+{
+    NetBuf &buf = p->con.getSendBuffer();
+    size_t start = buf.getFilled();
+    if (3 == p->version)
+        buf.addInt32(0);
+    return start;
+}
+
+
+/// Finish message started at specified position
+static void endMessage(NetProps *p, size_t start)
+{
+    NetBuf &buf = p->con.getSendBuffer();
+    if (3 == p->version)
+        buf.setInt32(start, buf.getFilled() - start - 4);
+}
+
+
+/// Send get properties values request
+static void sendGetProps(NetProps *p)
+{
+    size_t start = beginMessage(p);
+    p->con.getSendBuffer().addUint8(3);
+    endMessage(p, start);
+}
+
+
+
 PropValue::PropValue(NetProps *props, int id, int type, const char *name): 
     id(id), type(type), name(name), props(props)
 {
     memset(&lastValue, 0, sizeof(lastValue));
+    maxBufSize = 0;
     notUpdateTill = 0;
+    received = false;
 }
 
 
@@ -160,24 +215,27 @@ int PropValue::sendPropUpdate()
     props->lastSetSerial++;
     notUpdateTill = props->lastSetSerial;
     NetBuf &buf = props->con.getSendBuffer();
+    size_t start = beginMessage(props);
     buf.addUint8(2);
-    buf.addUint8(id);
+    addPropId(buf, props->version, id);
     buf.addUint8(type);
     buf.addUint16(props->lastSetSerial);
     switch (type) {
-        case PROP_INT: buf.addInt32(lastValue.intValue);  return 0;
-        case PROP_FLOAT: buf.addFloat(lastValue.floatValue);  return 0;
-        case PROP_DOUBLE: buf.addDouble(lastValue.doubleValue);  return 0;
-        case PROP_STRING: 
-            int len = 0;
-            if (lastValue.buf)
-                len = strlen(lastValue.buf);
-            buf.addUint16(len);
-            if (len)
-                buf.add((unsigned char*)lastValue.buf, len);
-            return 0;
+        case PROP_INT: buf.addInt32(lastValue.intValue);  break;
+        case PROP_FLOAT: buf.addFloat(lastValue.floatValue);  break;
+        case PROP_DOUBLE: buf.addDouble(lastValue.doubleValue);  break;
+        case PROP_STRING: {
+                int len = 0;
+                if (lastValue.buf)
+                    len = strlen(lastValue.buf);
+                buf.addUint16(len);
+                if (len)
+                    buf.add((unsigned char*)lastValue.buf, len);
+            }
+            break;
     }
-    return -1;
+    endMessage(props, start);
+    return 0;
 }
 
 
@@ -308,11 +366,11 @@ int PropValue::setString(const char *newValue)
         case PROP_DOUBLE: lastValue.doubleValue = strToDouble(newValue); break;
         case PROP_STRING: 
             int len = strlen(newValue);
-            if ((! lastValue.buf) || (len + 1 > lastValue.maxBufSize)) {
-                lastValue.maxBufSize = len + 20;
+            if ((! lastValue.buf) || (len + 1 > maxBufSize)) {
+                maxBufSize = len + 20;
                 if (lastValue.buf)
                     free(lastValue.buf);
-                lastValue.buf = (char*)malloc(lastValue.maxBufSize);
+                lastValue.buf = (char*)malloc(maxBufSize);
             }
             strcpy(lastValue.buf, newValue);
             break;
@@ -324,6 +382,7 @@ int PropValue::setString(const char *newValue)
         
 void PropValue::parse(const unsigned char *data, int revision)
 {
+    received = true;
     if (! ((revision >= notUpdateTill) || 
             ((65530 < notUpdateTill) && (10 > revision))))
     {
@@ -343,11 +402,11 @@ void PropValue::parse(const unsigned char *data, int revision)
             break;
         case PROP_STRING: 
             int len = netToInt16(data);
-            if ((! lastValue.buf) || (len + 1 > lastValue.maxBufSize)) {
-                lastValue.maxBufSize = len + 20;
+            if ((! lastValue.buf) || (len + 1 > maxBufSize)) {
+                maxBufSize = len + 20;
                 if (lastValue.buf)
                     free(lastValue.buf);
-                lastValue.buf = (char*)malloc(lastValue.maxBufSize);
+                lastValue.buf = (char*)malloc(maxBufSize);
             }
             memcpy(lastValue.buf, data + 2, len);
             lastValue.buf[len] = 0;
@@ -357,6 +416,29 @@ void PropValue::parse(const unsigned char *data, int revision)
 
 
 
+PropValue* PropValue::getElement(int index)
+{
+    if (0 > index)
+        return NULL;
+
+    if ((int)elements.size() <= index)
+        elements.resize(index + 1, NULL);
+
+    if (! elements[index]) {
+        std::string arrayName = name;
+        std::string::size_type pos = arrayName.find('[');
+        if (std::string::npos != pos)
+            arrayName.erase(pos);
+        std::string elementName = arrayName + "[" + toString(index) + "]";
+        elements[index] = (PropValue*)getSaslPropRef(props, 
+                elementName.c_str(), type);
+    }
+
+    return elements[index];
+}
+
+
+
 /// Returns reference to property
 static SaslPropRef createSaslPropRef(SaslProps props, const char *name, int type, 
         int maxSize, int cmd)
@@ -366,7 +448,7 @@ static SaslPropRef createSaslPropRef(SaslProps props, const char *name, int type
         return NULL;
 
     int id = p->values.size() + 1;
-    if ((255 < id) || (PROP_INT > type) || (PROP_STRING < type)) {
+    if ((PROP_INT > type) || (PROP_STRING < type)) {
         p->log.error("invalid property type %i\n", type);
         return NULL;
     }
@@ -377,16 +459,31 @@ static SaslPropRef createSaslPropRef(SaslProps props, const char *name, int type
             return v;
     }
 
-    p->values.push_back(new PropValue(p, id, type, name));
+    if (getMaxPropId(p->version) < id) {
+        p->log.error("too many properties, can't subscribe to %s\n", name);
+        return NULL;
+    }
+
     int len = strlen(name);
+    if (((3 == p->version) ? 0xFFFF : 0xFF) < len) {
+        p->log.error("property name is too long: %s\n", name);
+        return NULL;
+    }
+
+    p->values.push_back(new PropValue(p, id, type, name));
 
     NetBuf &buf = p->con.getSendBuffer();
+    size_t start = beginMessage(p);
     buf.addUint8(cmd);
     buf.addUint8(type);
-    buf.addUint8(id);
-    buf.addUint8(len);
-    buf.addUint8(maxSize);
+    addPropId(buf, p->version, id);
+    if (3 == p->version)
+        buf.addUint16(len);
+    else
+        buf.addUint8(len);
+    buf.addUint16(maxSize);
     buf.add((unsigned char*)name, len);
+    endMessage(p, start);
 
     return p->values[id - 1];
 }
@@ -395,13 +492,13 @@ static SaslPropRef createSaslPropRef(SaslProps props, const char *name, int type
 /// Get reference to property
 static SaslPropRef getSaslPropRef(SaslProps props, const char *name, int type)
 {
-    return createSaslPropRef(props, name, type, 1, 0);
+    return createSaslPropRef(props, name, type, 0, 1);
 }
 
 /// Get reference to property or create new property
 static SaslPropRef createProp(SaslProps props, const char *name, int type, int maxSize)
 {
-    return createSaslPropRef(props, name, type, 5, maxSize);
+    return createSaslPropRef(props, name, type, maxSize, 5);
 }
 
 /// create functional propert
@@ -529,6 +626,112 @@ static int setPropString(SaslPropRef prop, const char *newValue)
 }
 
 
+/// Subscribe to elements of array property.  Returns number of
+/// elements from offset which values are received from server.
+/// Elements past end of array are never received
+static int getAvailableElements(PropValue *value, int offset, int count)
+{
+    int available = count;
+    for (int i = 0; i < count; i++) {
+        PropValue *element = value->getElement(offset + i);
+        if (! element)
+            return (available < i) ? available : i;
+        if ((! element->isReceived()) && (available > i))
+            available = i;
+    }
+    return available;
+}
+
+
+/// Read elements of array property as integers
+static int getPropArrayInt(SaslPropRef prop, int offset, int count, 
+        int *values)
+{
+    PropValue *value = (PropValue*)prop;
+    if ((! value) || (! values) || (0 > offset) || (0 > count))
+        return -1;
+
+    int available = getAvailableElements(value, offset, count);
+    for (int i = 0; i < available; i++)
+        values[i] = value->getElement(offset + i)->getInt(NULL);
+
+    return available;
+}
+
+
+/// Write elements of array property as integers
+static int setPropArrayInt(SaslPropRef prop, int offset, int count, 
+        const int *values)
+{
+    PropValue *value = (PropValue*)prop;
+    if ((! value) || (! values) || (0 > offset) || (0 > count))
+        return -1;
+
+    int err = 0;
+    for (int i = 0; i < count; i++) {
+        PropValue *element = value->getElement(offset + i);
+        if (! element)
+            return -1;
+        err |= element->setInt(values[i]);
+    }
+
+    return err;
+}
+
+
+/// Read elements of array property as floats
+static int getPropArrayFloat(SaslPropRef prop, int offset, int count, 
+        float *values)
+{
+    PropValue *value = (PropValue*)prop;
+    if ((! value) || (! values) || (0 > offset) || (0 > count))
+        return -1;
+
+    int available = getAvailableElements(value, offset, count);
+    for (int i = 0; i < available; i++)
+        values[i] = value->getElement(offset + i)->getFloat(NULL);
+
+    return available;
+}
+
+
+/// Write elements of array property as floats
+static int setPropArrayFloat(SaslPropRef prop, int offset, int count, 
+        const float *values)
+{
+    PropValue *value = (PropValue*)prop;
+    if ((! value) || (! values) || (0 > offset) || (0 > count))
+        return -1;
+
+    int err = 0;
+    for (int i = 0; i < count; i++) {
+        PropValue *element = value->getElement(offset + i);
+        if (! element)
+            return -1;
+        err |= element->setFloat(values[i]);
+    }
+
+    return err;
+}
+
+
+/// Read values of group of properties as doubles
+static int getPropsDouble(const SaslPropRef *props, int count, double *values)
+{
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        PropValue *value = (PropValue*)props[i];
+        int err = 0;
+        values[i] = value ? value->getDouble(&err) : 0;
+        if ((! value) || err) {
+            values[i] = 0;
+            failed++;
+        }
+    }
+    return failed;
+}
+
+
 /// destroy properties
 static void doneProps(SaslProps props)
 {
@@ -538,6 +741,95 @@ static void doneProps(SaslProps props)
 }
 
 
+/// Ask server to push changes of property
+static int setPropPush(SaslPropRef prop, double rate, double deadband,
+        int relative)
+{
+    PropValue *v = (PropValue*)prop;
+    if (! v)
+        return -1;
+    NetProps *p = v->getProps();
+    if (3 != p->version)
+        return -1;
+
+    size_t start = beginMessage(p);
+    NetBuf &buf = p->con.getSendBuffer();
+    buf.addUint8(6);
+    addPropId(buf, p->version, v->getId());
+    buf.addFloat(rate);
+    buf.addUint8(relative ? 1 : 0);
+    buf.addDouble(deadband);
+    endMessage(p, start);
+    return 0;
+}
+
+
+/// Parse properties values message of protocol version 3.
+/// Returns non-zero on errors
+static int parseValues(NetProps *p, const unsigned char *data, size_t size)
+{
+    if ((7 > size) || ((4 != data[0]) && (7 != data[0]))) {
+        p->log.error("Invalid command %i\n", data[0]);
+        return -1;
+    }
+
+    int count = netToInt32(data + 1);
+    int serial = netToInt16(data + 5);
+    size_t pos = 7;
+
+    for (int i = 0; i < count; i++) {
+        if (pos + 4 > size)
+            return -1;
+        int propId = netToInt32(data + pos);
+        if ((0 >= propId) || (propId > (int)p->values.size())) {
+            p->log.error("invalid property id %i\n", propId);
+            return -1;
+        }
+        PropValue *v = p->values[propId - 1];
+        pos += 4;
+        size_t sz = getPropTypeSize(v->getType());
+        if (pos + sz > size)
+            return -1;
+        if (PROP_STRING == v->getType())
+            sz += netToInt16(data + pos);
+        if (pos + sz > size)
+            return -1;
+        v->parse(data + pos, serial);
+        pos += sz;
+    }
+
+    return (pos == size) ? 0 : -1;
+}
+
+
+/// Receive length-prefixed messages of protocol version 3
+static int updateFrames(NetProps *p)
+{
+    NetBuf &buf = p->con.getRecvBuffer();
+    while (4 <= buf.getFilled()) {
+        size_t size = (unsigned)netToInt32(buf.getData());
+        if ((! size) || (NETPROPS_MAX_FRAME < size)) {
+            p->log.error("Invalid message size %i\n", (int)size);
+            p->con.close();
+            return -1;
+        }
+        if (buf.getFilled() < size + 4)
+            break;
+        if (parseValues(p, buf.getData() + 4, size)) {
+            p->log.error("Invalid properties values message\n");
+            p->con.close();
+            return -1;
+        }
+        // pushed values (command 7) are sent by server without request
+        bool reply = 4 == buf.getData()[4];
+        buf.remove(size + 4);
+        if (reply)
+            sendGetProps(p);
+    }
+    return 0;
+}
+
+
 // do networked job
 static int updateProps(SaslProps props)
 {
@@ -548,10 +840,13 @@ static int updateProps(SaslProps props)
     if (p->con.update())
         return -1;
 
+    if (3 == p->version)
+        return updateFrames(p);
+
     bool isPropsAvailable = p->propsToGo;
 
     NetBuf &buf = p->con.getRecvBuffer();
-    if ((! p->propsToGo) && (2 <= buf.getFilled())) {
+    if ((! p->propsToGo) && (4 <= buf.getFilled())) {
         int id = buf.getData()[0];
         p->propsToGo = buf.getData()[1];
         p->curSetSerial = netToInt16(buf.getData() + 2);
@@ -585,7 +880,7 @@ static int updateProps(SaslProps props)
     }
 
     if ((! p->propsToGo) && (isPropsAvailable))
-        p->con.getSendBuffer().addUint8(3);
+        sendGetProps(p);
 
     return 0;
 }
@@ -595,36 +890,40 @@ static SaslPropsCallbacks callbacks = { getSaslPropRef, freeSaslPropRef, createP
         createFuncProp, getPropInt, setPropInt, getPropFloat, 
         setPropFloat, getPropDouble, setPropDouble, 
         getPropString, setPropString,
-        updateProps, doneProps };
+        updateProps, doneProps, getPropArrayInt, setPropArrayInt,
+        getPropArrayFloat, setPropArrayFloat, getPropsDouble, setPropPush };
 
 
-int xa::connectToServer(SASL sasl, Log &log, const char *host, int port, 
-        const char *secret)
+/// Connect to server and log in using specified protocol version.
+/// Returns NULL on errors
+static NetProps* login(Log &log, const char *host, int port, 
+        const char *secret, int version)
 {
     int sock = establishConnection(host, port);
-    log.debug("connecting...");
     if (1 > sock)
-        return -1;
+        return NULL;
 
     NetProps *np = new NetProps(log);
     np->con.setSocket(sock);
+    np->version = version;
     AsyncCon &con = np->con;
 
-    con.send((unsigned char*)"NP2\n", 4);
+    const char *magic = (3 == version) ? "NP3\n" : "NP2\n";
+    con.send((unsigned char*)magic, 4);
     if (con.sendAll()) {
         delete np;
-        return -1;
+        return NULL;
     }
 
     if (con.recvData(20)) {
         delete np;
-        return -1;
+        return NULL;
     }
 
     NetBuf &buf = con.getRecvBuffer();
-    if (20 != buf.getFilled()) {
+    if ((20 != buf.getFilled()) || memcmp(buf.getData(), magic, 4)) {
         delete np;
-        return -1;
+        return NULL;
     }
 
     md5_state_t md5;
@@ -638,32 +937,46 @@ int xa::connectToServer(SASL sasl, Log &log, const char *host, int port,
     con.send(digest, 16);
     if (con.sendAll()) {
         delete np;
-        return -1;
+        return NULL;
     }
     
     if (con.recvData(4) || (4 != buf.getFilled())) {
         log.error("can't receive result");
         delete np;
-        return -1;
+        return NULL;
     }
 
     if (memcmp(buf.getData(), "PASS", 4)) {
         log.error("we are not allowed");
         delete np;
-        return -1;
+        return NULL;
     }
     buf.remove(4);
-    log.debug("logged in!");
+
+    return np;
+}
+
+
+int xa::connectToServer(SASL sasl, Log &log, const char *host, int port, 
+        const char *secret)
+{
+    log.debug("connecting...");
+
+    // old servers drop connection on unknown protocol version
+    NetProps *np = login(log, host, port, secret, 3);
+    if (! np)
+        np = login(log, host, port, secret, 2);
+    if (! np)
+        return -1;
+    log.debug("logged in using protocol %i", np->version);
 
     np->propsToGo = 0;
     np->lastSetSerial = 0;
 
     sasl_set_props(sasl, &callbacks, np);
         
-    np->con.getSendBuffer().addUint8(3);
+    sendGetProps(np);
 
     return 0;
 }
 
-
-
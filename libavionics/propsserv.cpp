@@ -1,172 +1,546 @@
 #include "propsserv.h"
 
 #include <string.h>
+#include <math.h>
 #include "md5.h"
 #include "libavcallbacks.h"
 
 
 using namespace xa;
 
+SnapshotValue::SnapshotValue()
+{
+    type = 0;
+    version = 0;
+    memset(&value, 0, sizeof(value));
+}
+
+
+
+SharedValue::SharedValue()
+{
+    table = NULL;
+    type = 0;
+    slot = 0;
+    users = 0;
+}
+
+
+SharedValue::SharedValue(SharedValues *table, int type, 
+        const std::string &name, int slot):
+    table(table), type(type), name(name), slot(slot)
+{
+    users = 0;
+}
+
+
+int SharedValue::getVersion()
+{
+    const SnapshotValue *v = table->getValue(slot);
+    return v ? v->version : 0;
+}
+
+
+double SharedValue::getNumber()
+{
+    const SnapshotValue *v = table->getValue(slot);
+    if (! v)
+        return 0;
+    switch (type) {
+        case PROP_INT: return v->value.intValue;
+        case PROP_FLOAT: return v->value.floatValue;
+        case PROP_DOUBLE: return v->value.doubleValue;
+        default: return 0;
+    }
+}
+
+
+void SharedValue::write(NetBuf &buffer)
+{
+    static const SnapshotValue empty;
+    const SnapshotValue *v = table->getValue(slot);
+    if (! v)
+        v = &empty;
+    switch (type) {
+        case PROP_INT: buffer.addInt32(v->value.intValue); break;
+        case PROP_FLOAT: buffer.addFloat(v->value.floatValue); break;
+        case PROP_DOUBLE: buffer.addDouble(v->value.doubleValue); break;
+        case PROP_STRING: 
+            buffer.addUint16(v->stringValue.length());
+            buffer.add((const unsigned char*)v->stringValue.c_str(), 
+                    v->stringValue.length());
+            break;
+    }
+}
+
+
+void SharedValue::set(const SnapshotValue &value)
+{
+    table->setValue(slot, value);
+}
+
+
+
+SharedValues::SharedValues(TripleBuffer<PropsSnapshot> &snapshots, 
+        SpscQueue<PropsRequest> &requests): 
+    snapshots(snapshots), requests(requests)
+{
+    sentRequests = 0;
+    slotsCount = 0;
+}
+
+
+SharedValue* SharedValues::get(const std::string &name, int type, 
+        int maxSize, bool create)
+{
+    std::pair<int, std::string> key(type, name);
+    std::map<std::pair<int, std::string>, SharedValue>::iterator i = 
+        values.find(key);
+    bool found = i != values.end();
+    if (! found)
+        i = values.insert(std::make_pair(key, 
+                    SharedValue(this, type, name, allocateSlot()))).first;
+    SharedValue *value = &(*i).second;
+    value->users++;
+
+    // main thread creates property only if it isn't available yet
+    if ((! found) || create) {
+        PropsRequest request;
+        request.kind = create ? PropsRequest::CREATE : PropsRequest::SUBSCRIBE;
+        request.slot = value->getSlot();
+        request.name = name;
+        request.maxSize = maxSize;
+        request.value.type = type;
+        sendRequest(request);
+    }
+
+    return value;
+}
+
+
+void SharedValues::release(SharedValue *value)
+{
+    if ((! value) || (0 < --value->users))
+        return;
+
+    PropsRequest request;
+    request.kind = PropsRequest::RELEASE;
+    request.slot = value->getSlot();
+    request.maxSize = 0;
+    sendRequest(request);
+
+    // snapshots show old value in slot till main thread frees it
+    releasedSlots.push_back(std::make_pair(sentRequests, request.slot));
+
+    values.erase(std::make_pair(value->type, value->name));
+}
+
+
+int SharedValues::allocateSlot()
+{
+    if ((! releasedSlots.empty()) && 
+            (releasedSlots.front().first <= getAppliedRequests()))
+    {
+        int slot = releasedSlots.front().second;
+        releasedSlots.pop_front();
+        return slot;
+    }
+    return slotsCount++;
+}
+
+
+const SnapshotValue* SharedValues::getValue(int slot)
+{
+    PropsSnapshot &snapshot = snapshots.getFront();
+    if ((0 > slot) || (slot >= (int)snapshot.values.size()))
+        return NULL;
+    const SnapshotValue &value = snapshot.values[slot];
+    return value.version ? &value : NULL;
+}
+
+
+void SharedValues::setValue(int slot, const SnapshotValue &value)
+{
+    PropsRequest request;
+    request.kind = PropsRequest::SET;
+    request.slot = slot;
+    request.maxSize = 0;
+    request.value = value;
+    sendRequest(request);
+}
+
+
+void SharedValues::sendRequest(const PropsRequest &request)
+{
+    sentRequests++;
+    pending.push_back(request);
+    update();
+}
+
+
+void SharedValues::update()
+{
+    snapshots.update();
+
+    while (! pending.empty()) {
+        PropsRequest *request = requests.getTail();
+        if (! request)
+            break;
+        *request = pending.front();
+        requests.push();
+        pending.pop_front();
+    }
+}
+
+
+void SharedValues::clear()
+{
+    values.clear();
+    pending.clear();
+    releasedSlots.clear();
+    sentRequests = 0;
+    slotsCount = 0;
+}
+
+
+
 ClientProp::ClientProp()
 {
-    memset(&lastValue, 0, sizeof(lastValue));
+    value = NULL;
+    sentVersion = 0;
+    sentNumber = 0;
+    setPush(0, 0, false);
 }
 
 
 ClientProp::ClientProp(int id, int type, const std::string &name, 
-        Properties *properties, SaslPropRef ref):
-       id(id), type(type), name(name), properties(properties), ref(ref)
+        SharedValue *value):
+       id(id), type(type), name(name), value(value)
 {
-    sendNext = true;
-    memset(&lastValue, 0, sizeof(lastValue));
+    sentVersion = 0;
+    sentNumber = 0;
+    setPush(0, 0, false);
 }
 
-ClientProp::~ClientProp()
+
+/// Returns true if difference between values is greater than deadband
+static bool isOutside(double value, double last, double deadband, 
+        bool relative)
 {
-    if (lastValue.buf)
-        free(lastValue.buf);
+    double band = relative ? deadband * fabs(last) : deadband;
+    if (0 < band)
+        return fabs(value - last) > band;
+    else
+        return value != last;
 }
 
 
 bool ClientProp::isChanged()
 {
+    // property isn't read by main thread yet
+    int version = value->getVersion();
+    if (! version)
+        return false;
+
     if (sendNext)
         return true;
 
-    switch (type) {
-        case PROP_INT:
-            return properties->getPropi(ref) != lastValue.intValue;
-        case PROP_FLOAT:
-            return properties->getPropf(ref) != lastValue.floatValue;
-        case PROP_DOUBLE:
-            return properties->getPropd(ref) != lastValue.doubleValue;
-        case PROP_STRING:
-            {
-                std::string s = properties->getProps(ref);
-                return (! lastValue.buf) || (strcmp(s.c_str(), lastValue.buf));
-            }
-        default:
-            return false;
-    }
+    if (version == sentVersion)
+        return false;
+
+    if (PROP_STRING == type)
+        return true;
+    else
+        return isOutside(value->getNumber(), sentNumber, deadband, 
+                relativeDeadband);
+}
+
+
+void ClientProp::setPush(double rate, double deadband, bool relative)
+{
+    pushRate = (0 < rate) ? rate : 0;
+    this->deadband = (0 < deadband) ? deadband : 0;
+    relativeDeadband = relative;
+    lastPushTime = 0;
+    sendNext = true;
+}
+
+
+bool ClientProp::isPushDue(long now) const
+{
+    if (! isPushed())
+        return false;
+    return (now - lastPushTime) * pushRate >= 1000.0;
 }
 
 
-void ClientProp::send(NetBuf &buffer)
+void ClientProp::send(NetBuf &buffer, int version)
 {
     sendNext = false;
+    sentVersion = value->getVersion();
+    if (PROP_STRING != type)
+        sentNumber = value->getNumber();
 
-    buffer.addUint8(id);
-    switch (type) {
-        case PROP_INT: 
-            lastValue.intValue = properties->getPropi(ref);
-            buffer.addInt32(lastValue.intValue);
-            break;
-        case PROP_FLOAT:
-            lastValue.floatValue = properties->getPropf(ref);
-            buffer.addFloat(lastValue.floatValue);
-            break;
-        case PROP_DOUBLE:
-            lastValue.doubleValue = properties->getPropf(ref);
-            buffer.addDouble(lastValue.doubleValue);
-            break;
-        case PROP_STRING:
-            {
-                std::string s = properties->getProps(ref);
-                int len = s.length();
-                if ((! lastValue.buf) || (len + 1 > lastValue.maxBufSize)) {
-                    lastValue.maxBufSize = len + 20;
-                    if (lastValue.buf)
-                        free(lastValue.buf);
-                    lastValue.buf = (char*)malloc(lastValue.maxBufSize);
-                }
-                strcpy(lastValue.buf, s.c_str());
-                buffer.addUint16(len);
-                buffer.add((const unsigned char*)s.c_str(), len);
-            }
-            break;
-    }
+    addPropId(buffer, version, id);
+    value->write(buffer);
 }
 
 
 void ClientProp::setInt(int value)
 {
-    properties->setProp(ref, value);
+    SnapshotValue v;
+    v.type = PROP_INT;
+    v.value.intValue = value;
+    this->value->set(v);
 }
 
 
 void ClientProp::setFloat(float value)
 {
-    properties->setProp(ref, value);
+    SnapshotValue v;
+    v.type = PROP_FLOAT;
+    v.value.floatValue = value;
+    this->value->set(v);
 }
 
 
 void ClientProp::setDouble(double value)
 {
-    properties->setProp(ref, value);
+    SnapshotValue v;
+    v.type = PROP_DOUBLE;
+    v.value.doubleValue = value;
+    this->value->set(v);
 }
 
 void ClientProp::setString(const std::string &value)
 {
-    properties->setProp(ref, value);
+    SnapshotValue v;
+    v.type = PROP_STRING;
+    v.stringValue = value;
+    this->value->set(v);
 }
 
 
 
 
 PropsServer::PropsServer(Log &log, Properties &properties): 
-        log(log), server(log), properties(properties)
+        log(log), poller(netLog), server(netLog), requests(4096), 
+        values(snapshots, requests), properties(properties)
 {
+    netLog.setQueue(&logQueue);
+    appliedRequests = 0;
     server.setCallback(this);
+    server.setPoller(&poller);
 }
 
 
 PropsServer::~PropsServer()
 {
-    server.stop();
+    stop();
 }
 
 
 int PropsServer::start(const char *password, int port)
 {
+    stop();
+
     secret = password;
-    return server.start(port);
+    if (server.start(port))
+        return -1;
+
+    if (! thread.start(runThread, this)) {
+        log.error("can't start network thread\n");
+        server.stop();
+        return -1;
+    }
+
+    return 0;
 }
 
 
-int PropsServer::update()
+void PropsServer::runThread(void *server)
 {
-    int err = 0;
+    ((PropsServer*)server)->run();
+}
 
-    if (server.update()) {
-        log.error("tcp server error\n");
-        err = -1;
+
+void PropsServer::run()
+{
+    while (! stopping.get()) {
+        // single wait for all sockets, idle clients cost no system calls
+        if (poller.wait(10))
+            netLog.error("error waiting for network events\n");
+
+        values.update();
+
+        if (server.update())
+            netLog.error("tcp server error\n");
+
+        for (std::list<PropsClient>::iterator i = clients.begin(); 
+                i != clients.end(); )
+        {
+            if ((*i).update()) {
+                netLog.debug("closing client connection\n");
+                i = clients.erase(i);
+            } else
+                i++;
+        }
     }
+}
 
-    for (std::list<PropsClient>::iterator i = clients.begin(); 
-            i != clients.end(); )
+
+void PropsServer::readProp(ServerProp &prop)
+{
+    SnapshotValue &current = prop.current;
+    bool changed = ! current.version;
+    switch (current.type) {
+        case PROP_INT:
+            {
+                int v = properties.getPropi(prop.ref);
+                changed = changed || (v != current.value.intValue);
+                current.value.intValue = v;
+            }
+            break;
+        case PROP_FLOAT:
+            {
+                float v = properties.getPropf(prop.ref);
+                changed = changed || (v != current.value.floatValue);
+                current.value.floatValue = v;
+            }
+            break;
+        case PROP_DOUBLE:
+            {
+                double v = properties.getPropd(prop.ref);
+                changed = changed || (v != current.value.doubleValue);
+                current.value.doubleValue = v;
+            }
+            break;
+        case PROP_STRING:
+            {
+                const std::string &v = properties.getProps(prop.ref);
+                if (v != current.stringValue) {
+                    changed = true;
+                    current.stringValue = v;
+                }
+            }
+            break;
+    }
+
+    if (changed)
+        current.version++;
+}
+
+
+void PropsServer::applyRequest(const PropsRequest &request)
+{
+    if (PropsRequest::SET == request.kind) {
+        if ((request.slot >= (int)serverProps.size()) || 
+                (! serverProps[request.slot].ref))
+            return;
+        SaslPropRef ref = serverProps[request.slot].ref;
+        const SnapshotValue &v = request.value;
+        switch (v.type) {
+            case PROP_INT: properties.setProp(ref, v.value.intValue); break;
+            case PROP_FLOAT: properties.setProp(ref, v.value.floatValue); break;
+            case PROP_DOUBLE: 
+                properties.setProp(ref, v.value.doubleValue); 
+                break;
+            case PROP_STRING: properties.setProp(ref, v.stringValue); break;
+        }
+        return;
+    }
+
+    if (PropsRequest::RELEASE == request.kind) {
+        if (request.slot >= (int)serverProps.size())
+            return;
+        ServerProp &prop = serverProps[request.slot];
+        if (prop.ref)
+            properties.freeProp(prop.ref);
+        // slot will be reused by another property
+        prop = ServerProp();
+        return;
+    }
+
+    if (request.slot >= (int)serverProps.size())
+        serverProps.resize(request.slot + 1);
+    ServerProp &prop = serverProps[request.slot];
+    if (prop.ref)
+        return;
+
+    int type = request.value.type;
+    if (PropsRequest::CREATE == request.kind)
+        prop.ref = properties.createProp(request.name, type, request.maxSize);
+    else
+        prop.ref = properties.getProp(request.name, type);
+
+    if (! prop.ref)
+        log.error("Can't reference property %s\n", request.name.c_str());
+    else
+        prop.current.type = type;
+}
+
+
+int PropsServer::update()
+{
+    logQueue.flush(log);
+
+    for (PropsRequest *request = requests.getHead(); request; 
+            request = requests.getHead())
     {
-        if ((*i).update()) {
-            log.debug("closing client connection\n");
-            i = clients.erase(i);
-        } else
-            i++;
+        applyRequest(*request);
+        requests.pop();
+        appliedRequests++;
     }
 
-    return err;
+    // properties are read once per frame for all clients
+    PropsSnapshot &snapshot = snapshots.getBack();
+    snapshot.values.resize(serverProps.size());
+    for (size_t i = 0; i < serverProps.size(); i++) {
+        ServerProp &prop = serverProps[i];
+        if (prop.ref)
+            readProp(prop);
+        snapshot.values[i] = prop.current;
+    }
+    snapshot.appliedRequests = appliedRequests;
+    snapshots.publish();
+
+    return 0;
 }
 
 
 void PropsServer::stop()
 {
+    if (thread.isRunning()) {
+        stopping.set(1);
+        thread.join();
+        stopping.set(0);
+    }
+
     server.stop();
     clients.clear();
+    values.clear();
+    requests.clear();
+    snapshots.reset(PropsSnapshot());
+    freeServerProps();
+    appliedRequests = 0;
+    logQueue.flush(log);
+}
+
+
+void PropsServer::freeServerProps()
+{
+    for (std::vector<ServerProp>::iterator i = serverProps.begin();
+            i != serverProps.end(); i++)
+        if ((*i).ref)
+            properties.freeProp((*i).ref);
+    serverProps.clear();
 }
 
 
 void PropsServer::onConnectionReceived(int sock)
 {
-    clients.push_back(PropsClient(log, secret, properties));
-    clients.back().start(sock);
+    clients.push_back(PropsClient(netLog, secret, values));
+    clients.back().start(sock, &poller);
 }
 
 bool PropsServer::isRunning()
@@ -177,20 +551,25 @@ bool PropsServer::isRunning()
 
 
 
-PropsClient::PropsClient(Log &log, const std::string &secret, Properties &properties): 
-    log(log), con(log), secret(secret), properties(properties)
+PropsClient::PropsClient(Log &log, const std::string &secret, 
+        SharedValues &values): 
+    log(log), con(log), secret(secret), values(values)
 {
 }
 
 
 PropsClient::~PropsClient()
 {
+    for (std::map<int, ClientProp>::iterator i = propRefs.begin();
+            i != propRefs.end(); i++)
+        values.release((*i).second.getValue());
 }
 
 
-void PropsClient::start(int sock)
+void PropsClient::start(int sock, NetPoller *poller)
 {
     log.debug("starting connection\n");
+    con.setPoller(poller);
     if (con.setSocket(sock)) {
         log.error("error witching client to non-blockng mode\n");
         stop();
@@ -199,6 +578,8 @@ void PropsClient::start(int sock)
     con.setCallback(this);
     state = AUTH_HANDSHAKE;
     lastSetSerial = 0;
+    version = 2;
+    pushedCount = 0;
 }
 
 
@@ -208,6 +589,8 @@ int PropsClient::update()
         log.debug("client closed\n");
         return -1;
     }
+    if ((COMMAND == state) && pushedCount)
+        pushProps();
     int res = con.update();
     if (res) {
         log.error("error updaing client connection\n");
@@ -233,7 +616,11 @@ void PropsClient::doHandshake(NetBuf &buffer)
     if (4 > buffer.getFilled())
         return;
 
-    if (memcmp(buffer.getData(), "NP2\n", 4)) {
+    if (! memcmp(buffer.getData(), "NP3\n", 4))
+        version = 3;
+    else if (! memcmp(buffer.getData(), "NP2\n", 4))
+        version = 2;
+    else {
         log.error("invalid protocol!\n");
         stop();
         return;
@@ -241,7 +628,8 @@ void PropsClient::doHandshake(NetBuf &buffer)
 
     buffer.remove(4);
 
-    con.send((unsigned char*)"NP1\n", 4);
+    // client calculates checksum over this reply
+    con.send((unsigned char*)(3 == version ? "NP3\n" : "NP2\n"), 4);
 
     for (int i = 0; i < 16; i++)
         seed[i] = (unsigned char)rand();
@@ -259,7 +647,8 @@ void PropsClient::doVerify(NetBuf &buffer)
 
     md5_state_t md5;
     md5_init(&md5);
-    md5_append(&md5, (const md5_byte_t*)"NP2\n", 4);
+    md5_append(&md5, (const md5_byte_t*)(3 == version ? "NP3\n" : "NP2\n"), 
+            4);
     md5_append(&md5, seed, 16);
     md5_append(&md5, (const md5_byte_t*)secret.c_str(), secret.length());
     unsigned char digest[16];
@@ -279,143 +668,276 @@ void PropsClient::doVerify(NetBuf &buffer)
 }
 
 
-void PropsClient::handleSubscription(NetBuf &buffer)
+size_t PropsClient::beginMessage()
 {
-    if (4 > buffer.getFilled())
-        return;
-    unsigned int nameSize = buffer.getData()[3];
-    if (nameSize + 6 > buffer.getFilled())
-        return;
+    NetBuf &buffer = con.getSendBuffer();
+    size_t start = buffer.getFilled();
+    if (3 == version)
+        buffer.addInt32(0);
+    return start;
+}
+
 
-    int command = buffer.getData()[0];
-    int type = buffer.getData()[1];
-    int id = buffer.getData()[2];
-    int maxSize = netToInt16(buffer.getData() + 4);
-    std::string name((char*)buffer.getData() + 6, nameSize);
-    buffer.remove(nameSize + 6);
+void PropsClient::endMessage(size_t start)
+{
+    NetBuf &buffer = con.getSendBuffer();
+    if (3 == version)
+        buffer.setInt32(start, buffer.getFilled() - start - 4);
+}
+
+
+int PropsClient::handleSubscription(const unsigned char *data, size_t size)
+{
+    // protocol 3 uses 4 bytes IDs and 2 bytes name sizes
+    size_t idSize = getPropIdSize(version);
+    size_t nameSizeSize = (3 == version) ? 2 : 1;
+    size_t headerSize = 2 + idSize + nameSizeSize + 2;
+    if (headerSize > size)
+        return 0;
+
+    const unsigned char *p = data + 2 + idSize;
+    size_t nameSize = (3 == version) ? netToInt16(p) : p[0];
+    if (headerSize + nameSize > size)
+        return 0;
+
+    int command = data[0];
+    int type = data[1];
+    int id = netToPropId(data + 2, version);
+    int maxSize = netToInt16(p + nameSizeSize);
+    std::string name((const char*)data + headerSize, nameSize);
 
     if ((1 > type) || (4 < type)) {
         log.error("Invalid property type %i\n", type);
-        stop();
-        return;
+        return -1;
     }
 
-    SaslPropRef prop;
-
-    if (5 == command)
-        prop = properties.createProp(name, type, maxSize);
-    else
-        prop = properties.getProp(name, type);
+    // property is referenced by main thread, value will be sent when
+    // it appears in snapshot
+    SharedValue *value = values.get(name, type, maxSize, 5 == command);
 
-    if (! prop) {
-        log.error("Can't reference property %s\n", name.c_str());
-        return;
+    // ID could be reused for another property
+    std::map<int, ClientProp>::iterator i = propRefs.find(id);
+    if (i != propRefs.end()) {
+        if ((*i).second.isPushed())
+            pushedCount--;
+        values.release((*i).second.getValue());
     }
 
-    propRefs[id] = ClientProp(id, type, name, &properties, prop);
+    propRefs[id] = ClientProp(id, type, name, value);
+
+    return headerSize + nameSize;
 }
 
 
-void PropsClient::handleGetProps(NetBuf &buffer)
+void PropsClient::sendProps(int command, 
+        const std::list<ClientProp*> &props)
 {
-    buffer.remove(1);
+    long applied = values.getAppliedRequests();
+    while ((! pendingSerials.empty()) && 
+            (pendingSerials.front().first <= applied)) 
+    {
+        lastSetSerial = pendingSerials.front().second;
+        pendingSerials.pop_front();
+    }
 
+    NetBuf &buffer = con.getSendBuffer();
+    size_t start = beginMessage();
+    buffer.addUint8(command);
+    if (3 == version)
+        buffer.addInt32(props.size());
+    else
+        buffer.addUint8(props.size());
+    buffer.addUint16(lastSetSerial);
+
+    for (std::list<ClientProp*>::const_iterator i = props.begin(); 
+            i != props.end(); i++)
+    {
+        ClientProp *p = *i;
+        p->send(buffer, version);
+    }
+    endMessage(start);
+}
+
+
+int PropsClient::handleGetProps(const unsigned char *data, size_t size)
+{
     std::list<ClientProp*> propsToSend;
 
+    // pushed properties are sent from update only
     for (std::map<int, ClientProp>::iterator i = propRefs.begin();
             i != propRefs.end(); i++)
     {
         ClientProp &p = (*i).second;
-        if (p.isChanged()) 
+        if ((! p.isPushed()) && p.isChanged()) 
             propsToSend.push_back(&p);
     }
     
-    con.getSendBuffer().addUint8(4);
-    con.getSendBuffer().addUint8(propsToSend.size());
-    con.getSendBuffer().addUint16(lastSetSerial);
+    sendProps(4, propsToSend);
 
-    for (std::list<ClientProp*>::iterator i = propsToSend.begin(); 
-            i != propsToSend.end(); i++)
+    return 1;
+}
+
+
+void PropsClient::pushProps()
+{
+    std::list<ClientProp*> propsToSend;
+    long now = values.getTime();
+
+    for (std::map<int, ClientProp>::iterator i = propRefs.begin();
+            i != propRefs.end(); i++)
     {
-        ClientProp *p = *i;
-        p->send(con.getSendBuffer());
+        ClientProp &p = (*i).second;
+        if (p.isPushDue(now) && p.isChanged()) {
+            p.setPushTime(now);
+            propsToSend.push_back(&p);
+        }
     }
+
+    if (! propsToSend.empty())
+        sendProps(7, propsToSend);
 }
 
 
-void PropsClient::handleSetProp(NetBuf &buffer)
+int PropsClient::handlePushProp(const unsigned char *data, size_t size)
 {
-    const unsigned char *command = buffer.getData();
+    if (3 != version) {
+        log.error("Push requires protocol version 3\n");
+        return -1;
+    }
 
-    if (9 > buffer.getFilled())
-        return;
+    size_t msgSize = 1 + getPropIdSize(version) + 4 + 1 + 8;
+    if (msgSize > size)
+        return 0;
 
-    unsigned int sz = 5;
-    int dataSz = getPropTypeSize(command[2]);
-    if (! dataSz) {
-        log.error("Invalid property type %i\n", command[2]);
-        stop();
-        return;
+    int id = netToPropId(data + 1, version);
+    const unsigned char *p = data + 1 + getPropIdSize(version);
+    float rate = netToFloat(p);
+    bool relative = 0 != p[4];
+    double deadband = netToDouble(p + 5);
+
+    std::map<int, ClientProp>::iterator i = propRefs.find(id);
+    if (i == propRefs.end()) {
+        log.warning("preoperty %i doesn't exists\n", id);
+        return -1;
     }
-    sz += dataSz;
+    ClientProp &prop = (*i).second;
+
+    if (prop.isPushed())
+        pushedCount--;
+    prop.setPush(rate, deadband, relative);
+    if (prop.isPushed())
+        pushedCount++;
+
+    return msgSize;
+}
 
-    if (buffer.getFilled() < sz)
-        return;
 
-    if (PROP_STRING == getPropTypeSize(command[2])) {
-        dataSz = netToInt16(command + 5);
-        sz += dataSz;
+int PropsClient::handleSetProp(const unsigned char *data, size_t size)
+{
+    size_t idSize = getPropIdSize(version);
+    size_t headerSize = 1 + idSize + 1 + 2;
+    if (headerSize > size)
+        return 0;
+
+    int type = data[1 + idSize];
+    size_t dataSz = getPropTypeSize(type);
+    if (! dataSz) {
+        log.error("Invalid property type %i\n", type);
+        return -1;
     }
-    if (buffer.getFilled() < sz)
-        return;
 
-    lastSetSerial = netToInt16(command + 3);
+    const unsigned char *value = data + headerSize;
+    if (headerSize + dataSz > size)
+        return 0;
+    if (PROP_STRING == type) {
+        dataSz += netToInt16(value);
+        if (headerSize + dataSz > size)
+            return 0;
+    }
 
-    std::map<int, ClientProp>::iterator i = propRefs.find(command[1]);
+    int serial = netToInt16(data + 2 + idSize);
+
+    int id = netToPropId(data + 1, version);
+    std::map<int, ClientProp>::iterator i = propRefs.find(id);
     if (i == propRefs.end()) {
-        log.warning("preoperty %i doesn't exists\n", command[1]);
-        buffer.remove(sz);
-        stop();
-        return;
+        log.warning("preoperty %i doesn't exists\n", id);
+        return -1;
     }
     ClientProp &prop = (*i).second;
 
-    switch (command[2]) {
-        case PROP_INT: prop.setInt(netToInt32(command + 5)); break;
-        case PROP_FLOAT: prop.setFloat(netToFloat(command + 5)); break;
-        case PROP_DOUBLE: prop.setDouble(netToDouble(command + 5)); break;
+    switch (type) {
+        case PROP_INT: prop.setInt(netToInt32(value)); break;
+        case PROP_FLOAT: prop.setFloat(netToFloat(value)); break;
+        case PROP_DOUBLE: prop.setDouble(netToDouble(value)); break;
         case PROP_STRING:
-            prop.setString(std::string((const char*)command + 7, dataSz));
+            prop.setString(std::string((const char*)value + 2, dataSz - 2));
             break;
+    }
+
+    // serial is reported after main thread sets property
+    pendingSerials.push_back(std::make_pair(values.getSentRequests(), serial));
+        
+    return headerSize + dataSz;
+}
+
+
+int PropsClient::handleMessage(const unsigned char *data, size_t size)
+{
+    int command = data[0];
+    switch (command) {
+        case 1:
+        case 5: return handleSubscription(data, size);
+        case 2: return handleSetProp(data, size);
+        case 3: return handleGetProps(data, size);
+        case 6: return handlePushProp(data, size);
         default:
-            log.error("invalid property type %i\n", command[2]);
+            log.error("Invalid command %i\n", command);
+            return -1;
+    }
+}
+
+
+void PropsClient::doFrames(NetBuf &buffer)
+{
+    while ((COMMAND == state) && (4 <= buffer.getFilled())) {
+        size_t size = (unsigned)netToInt32(buffer.getData());
+        if ((! size) || (NETPROPS_MAX_FRAME < size)) {
+            log.error("Invalid message size %i\n", (int)size);
             stop();
+            return;
+        }
+        if (buffer.getFilled() < size + 4)
+            return;
+
+        int used = handleMessage(buffer.getData() + 4, size);
+        if (used != (int)size) {
+            if (0 <= used)
+                log.error("Invalid message size %i\n", (int)size);
+            stop();
+            return;
+        }
+        buffer.remove(size + 4);
     }
-        
-    buffer.remove(sz);
 }
 
 
 void PropsClient::doCommand(NetBuf &buffer)
 {
-    if (! buffer.getFilled())
+    if (3 == version) {
+        doFrames(buffer);
         return;
+    }
 
-    size_t lastFilled;
-    do {
-        lastFilled = buffer.getFilled();
-        int command = buffer.getData()[0];
-        switch (command) {
-            case 1:
-            case 5: handleSubscription(buffer);  break;
-            case 2: handleSetProp(buffer);  break;
-            case 3: handleGetProps(buffer);  break;
-            default:
-                log.error("Invalid command %i\n", command);
-                stop();
+    while ((COMMAND == state) && buffer.getFilled()) {
+        int used = handleMessage(buffer.getData(), buffer.getFilled());
+        if (0 > used) {
+            stop();
+            return;
         }
-    } while ((COMMAND == state) && (buffer.getFilled() != lastFilled) && 
-            buffer.getFilled());
+        if (! used)
+            return;
+        buffer.remove(used);
+    }
 }
 
 
@@ -5,14 +5,235 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
 #include "lownet.h"
 #include "properties.h"
 #include "log.h"
+#include "logqueue.h"
+#include "lockfree.h"
+#include "rttimer.h"
 
 
 namespace xa {
 
 
+/// Value of property in snapshot published by main thread
+struct SnapshotValue
+{
+    /// Type of property
+    int type;
+
+    /// Incremented each time value changes.  Zero if property isn't
+    /// available
+    int version;
+
+    /// Value of numeric property
+    union {
+        int intValue;
+        float floatValue;
+        double doubleValue;
+    } value;
+
+    /// Value of string property
+    std::string stringValue;
+
+    SnapshotValue();
+};
+
+
+/// Values of subscribed properties published by main thread
+struct PropsSnapshot
+{
+    /// Values of properties indexed by slot number
+    std::vector<SnapshotValue> values;
+
+    /// Number of requests processed by main thread before snapshot
+    long appliedRequests;
+
+    PropsSnapshot(): appliedRequests(0) { };
+};
+
+
+/// Request passed from network thread to main thread
+struct PropsRequest
+{
+    enum Kind {
+        /// Start reading of property
+        SUBSCRIBE,
+
+        /// Start reading of property, create property if needed
+        CREATE,
+
+        /// Set property value
+        SET,
+
+        /// Stop reading of property and free its reference
+        RELEASE
+    };
+
+    /// Kind of request
+    Kind kind;
+
+    /// Slot number of property
+    int slot;
+
+    /// Name of property to subscribe
+    std::string name;
+
+    /// Maximum size of created string property
+    int maxSize;
+
+    /// Type of property and value to set
+    SnapshotValue value;
+};
+
+
+/// Property subscribed by clients.  Used by main thread only
+struct ServerProp
+{
+    /// Reference to property or NULL if not available
+    SaslPropRef ref;
+
+    /// Last read value of property
+    SnapshotValue current;
+
+    ServerProp(): ref(NULL) { };
+};
+
+
+class SharedValues;
+
+
+/// Value of property shared by all clients subscribed to it.
+/// Values are read from latest snapshot published by main thread
+class SharedValue
+{
+    private:
+        /// Table this value belongs to
+        SharedValues *table;
+
+        /// Type of property
+        int type;
+
+        /// Name of property
+        std::string name;
+
+        /// Slot number of property in snapshots
+        int slot;
+
+        /// Number of client properties referencing this value
+        int users;
+
+        friend class SharedValues;
+
+    public:
+        SharedValue();
+
+        /// Create value of property
+        SharedValue(SharedValues *table, int type, const std::string &name,
+                int slot);
+
+    public:
+        /// Returns version of value or zero if property isn't available
+        int getVersion();
+
+        /// Returns value of numeric property as double
+        double getNumber();
+
+        /// Write value to buffer in network format
+        void write(NetBuf &buffer);
+
+        /// Ask main thread to set property value
+        void set(const SnapshotValue &value);
+
+        /// Returns slot number of property
+        int getSlot() const { return slot; }
+};
+
+
+/// Values of all properties subscribed by clients.
+/// Used by network thread only
+class SharedValues
+{
+    private:
+        /// Snapshots published by main thread
+        TripleBuffer<PropsSnapshot> &snapshots;
+
+        /// Requests to main thread
+        SpscQueue<PropsRequest> &requests;
+
+        /// Requests which didn't fit into queue
+        std::list<PropsRequest> pending;
+
+        /// Values mapped by type and name of property
+        std::map<std::pair<int, std::string>, SharedValue> values;
+
+        /// Number of slots allocated
+        int slotsCount;
+
+        /// Slots of released values and numbers of requests main thread
+        /// should process before slot could be reused
+        std::list<std::pair<long, int> > releasedSlots;
+
+        /// Number of requests sent to main thread
+        long sentRequests;
+
+        /// Network thread timer
+        RtTimer timer;
+
+    public:
+        /// Create empty table
+        SharedValues(TripleBuffer<PropsSnapshot> &snapshots, 
+                SpscQueue<PropsRequest> &requests);
+
+    public:
+        /// Returns value of property.  Value is created and main thread
+        /// is asked to read property on first request.  Each returned
+        /// value should be released when it isn't needed anymore
+        /// \param name name of property.
+        /// \param type type of property.
+        /// \param maxSize maximum size of string property.
+        /// \param create if true property will be created if not exists.
+        SharedValue* get(const std::string &name, int type, int maxSize,
+                bool create);
+
+        /// Release value returned by get.  Main thread is asked to free
+        /// property when last user releases it
+        void release(SharedValue *value);
+
+        /// Returns value of property in latest snapshot or NULL if 
+        /// property isn't available
+        const SnapshotValue* getValue(int slot);
+
+        /// Ask main thread to set value of property
+        void setValue(int slot, const SnapshotValue &value);
+
+        /// Returns number of requests sent to main thread
+        long getSentRequests() const { return sentRequests; }
+
+        /// Returns number of requests processed by main thread
+        long getAppliedRequests() { return snapshots.getFront().appliedRequests; }
+
+        /// Pick up latest snapshot and pass pending requests to main thread
+        void update();
+
+        /// Returns current time in milliseconds
+        long getTime() { return timer.getTime(); }
+
+        /// Forget all values
+        void clear();
+
+    private:
+        /// Queue request to main thread
+        void sendRequest(const PropsRequest &request);
+
+        /// Returns free slot number.  Released slots are reused after
+        /// main thread cleared them
+        int allocateSlot();
+};
+
+
+
 /// Property requested by client
 class ClientProp
 {
@@ -29,37 +250,62 @@ class ClientProp
         /// if true will resend it next time anyway
         bool sendNext;
 
-        /// last known value of property
-        union {
-            int intValue;
-            float floatValue;
-            double doubleValue;
+        /// Shared value of property
+        SharedValue *value;
 
-            char *buf;
-            int maxBufSize;
-        } lastValue;
+        /// Version of shared value sent last time
+        int sentVersion;
 
-        /// Properties subsystem
-        Properties *properties;
+        /// Last sent value of numeric property
+        double sentNumber;
+
+        /// Maximum number of pushed updates per second.
+        /// Zero if property is sent on client requests only
+        double pushRate;
+
+        /// Minimum change of value to send
+        double deadband;
+
+        /// If true deadband is fraction of last sent value
+        bool relativeDeadband;
 
-        /// Reference to property
-        SaslPropRef ref;
+        /// Time when property was pushed last time in milliseconds
+        long lastPushTime;
 
     public:
         ClientProp();
 
         /// Create new reference to property
         ClientProp(int id, int type, const std::string &name, 
-                Properties *properties, SaslPropRef ref);
-        
-        ~ClientProp();
+                SharedValue *value);
 
     public:
+        /// Returns shared value of property
+        SharedValue* getValue() const { return value; }
+
         /// Returns true if property needed to send
         bool isChanged();
 
+        /// Setup push of property changes
+        /// \param rate maximum updates per second.  0 disables push.
+        /// \param deadband minimum change of value to send.
+        /// \param relative if true deadband is fraction of last value.
+        void setPush(double rate, double deadband, bool relative);
+
+        /// Returns true if property changes are pushed to client
+        bool isPushed() const { return 0 < pushRate; }
+
+        /// Returns true if property is pushed and it is time to push it
+        /// \param now current time in milliseconds.
+        bool isPushDue(long now) const;
+
+        /// Remember time when property was pushed
+        void setPushTime(long now) { lastPushTime = now; }
+
         /// Write property to buffer
-        void send(NetBuf &buffer);
+        /// \param buffer buffer to write property to.
+        /// \param version protocol version.
+        void send(NetBuf &buffer, int version);
 
         /// Set property value as integer
         void setInt(int value);
@@ -102,8 +348,8 @@ class PropsClient: private NetReceiver
         /// random sequence
         unsigned char seed[16];
 
-        /// Properties subsystem
-        Properties &properties;
+        /// Values of properties shared by all clients
+        SharedValues &values;
 
         /// Properties names.
         std::map<int, ClientProp> propRefs;
@@ -111,16 +357,28 @@ class PropsClient: private NetReceiver
         /// last seen set property serial
         int lastSetSerial;
 
+        /// Serials of set requests not processed by main thread yet
+        /// and numbers of requests to wait for
+        std::list<std::pair<long, int> > pendingSerials;
+
+        /// Protocol version requested by client
+        int version;
+
+        /// Number of properties with push enabled
+        int pushedCount;
+
     public:
         /// Create new connection to client
-        PropsClient(Log &log, const std::string &secret, Properties &properties);
+        PropsClient(Log &log, const std::string &secret, SharedValues &values);
 
         /// Destroy connection to client
         ~PropsClient();
 
     public:
         /// move client to working state
-        void start(int sock);
+        /// \param sock client socket.
+        /// \param poller poller to watch socket.
+        void start(int sock, NetPoller *poller);
 
         /// proceed connection operations
         int update();
@@ -141,36 +399,96 @@ class PropsClient: private NetReceiver
         /// process command message
         void doCommand(NetBuf &buffer);
 
+        /// process length-prefixed messages of protocol version 3
+        void doFrames(NetBuf &buffer);
+
+        /// Handle single message.  Message handlers return size of
+        /// message, zero if message is incomplete or -1 on error
+        /// \param data message data.
+        /// \param size number of bytes available.
+        int handleMessage(const unsigned char *data, size_t size);
+
         /// Handle subscription message
-        void handleSubscription(NetBuf &buffer);
+        int handleSubscription(const unsigned char *data, size_t size);
         
         /// Handle set property value message
-        void handleSetProp(NetBuf &buffer);
+        int handleSetProp(const unsigned char *data, size_t size);
         
         /// Handle get properties values message
-        void handleGetProps(NetBuf &buffer);
+        int handleGetProps(const unsigned char *data, size_t size);
+
+        /// Handle setup of property push message
+        int handlePushProp(const unsigned char *data, size_t size);
+
+        /// Send values of properties which have to be pushed
+        void pushProps();
+
+        /// Write properties values message
+        /// \param command message command code.
+        /// \param props properties to send.
+        void sendProps(int command, const std::list<ClientProp*> &props);
+
+        /// Start new message in send buffer.  Returns position of message
+        size_t beginMessage();
+
+        /// Finish message started at specified position
+        void endMessage(size_t start);
 };
 
 
-/// Serve properties connections
+/// Serve properties connections.
+/// Network communications are done in separate thread.  Main thread
+/// reads subscribed properties once per frame and publishes snapshot of
+/// their values, requests of network thread are passed back through queue
 class PropsServer: private ConnectionAcceptor
 {
     private:
         /// logger to use
         Log &log;
 
+        /// Messages logged by network thread
+        LogQueue logQueue;
+
+        /// Logger of network thread
+        Log netLog;
+
         /// secret word
         std::string secret;
 
+        /// Waits for events of server and clients sockets
+        NetPoller poller;
+
         /// TCP server object
         TcpServer server;
 
+        /// Snapshots of properties values published by main thread
+        TripleBuffer<PropsSnapshot> snapshots;
+
+        /// Requests of network thread to main thread
+        SpscQueue<PropsRequest> requests;
+
+        /// Values of properties subscribed by clients
+        SharedValues values;
+
         /// Active connetions
         std::list<PropsClient> clients;
         
         /// Properties subsystem
         Properties &properties;
 
+        /// Properties subscribed by clients indexed by slot number.
+        /// Used by main thread only
+        std::vector<ServerProp> serverProps;
+
+        /// Number of requests processed by main thread
+        long appliedRequests;
+
+        /// Network thread
+        Thread thread;
+
+        /// Non-zero if network thread should exit
+        AtomicInt stopping;
+
     public:
         /// create props server
         PropsServer(Log &log, Properties &properties);
@@ -182,7 +500,8 @@ class PropsServer: private ConnectionAcceptor
         /// Start properties server
         int start(const char *secret, int port);
 
-        /// Do networking communications
+        /// Publish properties values to network thread and process its
+        /// requests.  Called by main thread once per frame
         int update();
 
         /// stop props server
@@ -194,6 +513,21 @@ class PropsServer: private ConnectionAcceptor
     private:
         /// create new connection
         virtual void onConnectionReceived(int sock);
+
+        /// Network thread function
+        static void runThread(void *server);
+
+        /// Serve clients until stop
+        void run();
+
+        /// Process request of network thread
+        void applyRequest(const PropsRequest &request);
+
+        /// Free references of all subscribed properties
+        void freeServerProps();
+
+        /// Read value of property into its slot
+        void readProp(ServerProp &prop);
 };
 
 
@@ -0,0 +1,202 @@
+#include "propsstats.h"
+
+#include <stdio.h>
+#include <vector>
+#include "libavionics.h"
+#include "avionics.h"
+
+
+using namespace xa;
+
+
+#ifndef NO_PROPS_STATS
+
+void PropsStats::addRead(SaslPropRef prop, double start)
+{
+    Entry &e = entries[prop];
+    e.reads++;
+    e.readTime += timer.getPreciseTime() - start;
+}
+
+
+void PropsStats::addReads(const SaslPropRef *refs, int count, double start)
+{
+    if ((! enabled) || (0 >= count))
+        return;
+
+    double time = (timer.getPreciseTime() - start) / count;
+    for (int i = 0; i < count; i++) {
+        Entry &e = entries[refs[i]];
+        e.reads++;
+        e.readTime += time;
+    }
+}
+
+
+void PropsStats::countWrite(SaslPropRef prop, double value)
+{
+    Entry &e = entries[prop];
+    e.writes++;
+    if (e.written && (e.lastNumber == value))
+        e.redundantWrites++;
+    e.written = true;
+    e.lastNumber = value;
+}
+
+
+void PropsStats::countWrite(SaslPropRef prop, const std::string &value)
+{
+    Entry &e = entries[prop];
+    e.writes++;
+    if (e.written && (e.lastString == value))
+        e.redundantWrites++;
+    e.written = true;
+    e.lastString = value;
+}
+
+
+void PropsStats::addWriteTime(SaslPropRef prop, double start)
+{
+    entries[prop].writeTime += timer.getPreciseTime() - start;
+}
+
+
+void PropsStats::reset()
+{
+    for (Entries::iterator i = entries.begin(); i != entries.end(); i++) {
+        Entry &e = (*i).second;
+        e.reads = e.writes = e.redundantWrites = 0;
+        e.readTime = e.writeTime = 0;
+        e.written = false;
+    }
+}
+
+
+int PropsStats::getStats(struct SaslPropStats *stats, int maxStats) const
+{
+    int count = 0;
+    for (Entries::const_iterator i = entries.begin(); i != entries.end(); 
+            i++)
+    {
+        const Entry &e = (*i).second;
+        if ((! e.reads) && (! e.writes))
+            continue;
+        if (stats && (count < maxStats)) {
+            SaslPropStats &s = stats[count];
+            s.name = e.name.c_str();
+            s.reads = e.reads;
+            s.writes = e.writes;
+            s.redundantWrites = e.redundantWrites;
+            s.readTime = e.readTime;
+            s.writeTime = e.writeTime;
+        }
+        count++;
+    }
+    return count;
+}
+
+
+int PropsStats::dump(const char *fileName) const
+{
+    FILE *f = fopen(fileName, "w");
+    if (! f)
+        return -1;
+
+    fprintf(f, "name,reads,writes,redundant_writes,read_time_ms,"
+            "write_time_ms\n");
+    for (Entries::const_iterator i = entries.begin(); i != entries.end(); 
+            i++)
+    {
+        const Entry &e = (*i).second;
+        if ((! e.reads) && (! e.writes))
+            continue;
+
+        // names are quoted, quotes inside names are doubled
+        fputc('"', f);
+        for (const char *c = e.name.c_str(); *c; c++) {
+            if ('"' == *c)
+                fputc('"', f);
+            fputc(*c, f);
+        }
+        fprintf(f, "\",%i,%i,%i,%.3f,%.3f\n", e.reads, e.writes, 
+                e.redundantWrites, e.readTime, e.writeTime);
+    }
+
+    int err = ferror(f);
+    fclose(f);
+    return err ? -1 : 0;
+}
+
+#endif
+
+
+
+/// Enable or disable counting of property accesses
+static int luaEnablePropsStats(lua_State *L)
+{
+    getAvionics(L)->getProps().getStats().setEnabled(lua_toboolean(L, 1));
+    return 0;
+}
+
+
+/// Forget collected statistics
+static int luaResetPropsStats(lua_State *L)
+{
+    getAvionics(L)->getProps().getStats().reset();
+    return 0;
+}
+
+
+/// Returns array of properties statistics
+static int luaGetPropsStats(lua_State *L)
+{
+    PropsStats &propsStats = getAvionics(L)->getProps().getStats();
+
+    int count = propsStats.getStats(NULL, 0);
+    std::vector<SaslPropStats> stats(count);
+    if (count)
+        propsStats.getStats(&stats[0], count);
+
+    lua_createtable(L, count, 0);
+    for (int i = 0; i < count; i++) {
+        const SaslPropStats &s = stats[i];
+        lua_createtable(L, 0, 6);
+        lua_pushstring(L, s.name);
+        lua_setfield(L, -2, "name");
+        lua_pushnumber(L, s.reads);
+        lua_setfield(L, -2, "reads");
+        lua_pushnumber(L, s.writes);
+        lua_setfield(L, -2, "writes");
+        lua_pushnumber(L, s.redundantWrites);
+        lua_setfield(L, -2, "redundantWrites");
+        lua_pushnumber(L, s.readTime);
+        lua_setfield(L, -2, "readTime");
+        lua_pushnumber(L, s.writeTime);
+        lua_setfield(L, -2, "writeTime");
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    return 1;
+}
+
+
+/// Write statistics to CSV file.  Returns true on success
+static int luaDumpPropsStats(lua_State *L)
+{
+    const char *fileName = lua_tostring(L, 1);
+    lua_pushboolean(L, fileName && 
+            (! getAvionics(L)->getProps().getStats().dump(fileName)));
+    return 1;
+}
+
+
+void xa::exportPropsStatsToLua(Luna &lua)
+{
+    lua_State *L = lua.getLua();
+
+    lua_register(L, "enablePropsStats", luaEnablePropsStats);
+    lua_register(L, "resetPropsStats", luaResetPropsStats);
+    lua_register(L, "getPropsStats", luaGetPropsStats);
+    lua_register(L, "dumpPropsStats", luaDumpPropsStats);
+}
+
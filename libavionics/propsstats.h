@@ -0,0 +1,211 @@
+#ifndef __PROPS_STATS_H__
+#define __PROPS_STATS_H__
+
+
+#include <string>
+#include <map>
+#include "libavcallbacks.h"
+#include "luna.h"
+#include "rttimer.h"
+
+
+struct SaslPropStats;
+
+
+namespace xa {
+
+
+#ifndef NO_PROPS_STATS
+
+/// Counts reads and writes of each property and time spent in
+/// properties callbacks.  Counting is disabled by default.
+/// Define NO_PROPS_STATS to compile it out
+class PropsStats
+{
+    private:
+        /// Statistics of single property reference
+        struct Entry
+        {
+            /// Name of property
+            std::string name;
+
+            /// Number of reads
+            int reads;
+
+            /// Number of writes
+            int writes;
+
+            /// Number of writes of value equal to previous written one
+            int redundantWrites;
+
+            /// Time spent in reads
+            double readTime;
+
+            /// Time spent in writes
+            double writeTime;
+
+            /// True if lastNumber or lastString is set
+            bool written;
+
+            /// Last value written to numeric property
+            double lastNumber;
+
+            /// Last value written to string property
+            std::string lastString;
+
+            Entry(): reads(0), writes(0), redundantWrites(0), readTime(0),
+                writeTime(0), written(false), lastNumber(0) { };
+        };
+
+        /// Statistics mapped by property reference
+        typedef std::map<SaslPropRef, Entry> Entries;
+
+        /// Statistics of properties
+        Entries entries;
+
+        /// True if counting is enabled
+        bool enabled;
+
+        /// Timer for measurements
+        RtTimer timer;
+
+    public:
+        /// Measures single read of property
+        class Read
+        {
+            private:
+                PropsStats &stats;
+                SaslPropRef prop;
+                double start;
+
+            public:
+                Read(PropsStats &stats, SaslPropRef prop): stats(stats), 
+                    prop(prop), start(stats.getStartTime()) { };
+
+                ~Read() { if (stats.enabled) stats.addRead(prop, start); };
+        };
+
+        /// Measures single write of property
+        class Write
+        {
+            private:
+                PropsStats &stats;
+                SaslPropRef prop;
+                double start;
+
+            public:
+                /// Write of numeric value
+                Write(PropsStats &stats, SaslPropRef prop, double value): 
+                    stats(stats), prop(prop), start(stats.getStartTime()) 
+                { 
+                    if (stats.enabled) stats.countWrite(prop, value);
+                };
+
+                /// Write of string value
+                Write(PropsStats &stats, SaslPropRef prop, 
+                        const std::string &value): stats(stats), prop(prop),
+                    start(stats.getStartTime())
+                {
+                    if (stats.enabled) stats.countWrite(prop, value);
+                };
+
+                /// Write of array elements
+                Write(PropsStats &stats, SaslPropRef prop): stats(stats), 
+                    prop(prop), start(stats.getStartTime())
+                {
+                    if (stats.enabled) stats.entries[prop].writes++;
+                };
+
+                ~Write() { if (stats.enabled) stats.addWriteTime(prop, start); };
+        };
+
+    public:
+        PropsStats(): enabled(false) { };
+
+    public:
+        /// Enable or disable counting
+        void setEnabled(bool enable) { enabled = enable; };
+
+        /// Returns true if counting is enabled
+        bool isEnabled() const { return enabled; };
+
+        /// Remember name of property reference.  Names are stored even
+        /// if counting is disabled, so later reports are readable
+        void setName(SaslPropRef prop, const std::string &name) { 
+            entries[prop].name = name; };
+
+        /// Count read of several properties at once
+        void addReads(const SaslPropRef *refs, int count, double start);
+
+        /// Returns time of access start or zero if counting is disabled
+        double getStartTime() { 
+            return enabled ? timer.getPreciseTime() : 0; };
+
+        /// Forget collected statistics
+        void reset();
+
+        /// Copy collected statistics.  Returns number of properties
+        /// accessed which may be greater than maxStats.
+        int getStats(struct SaslPropStats *stats, int maxStats) const;
+
+        /// Write statistics to CSV file.  Returns zero on success
+        int dump(const char *fileName) const;
+
+    private:
+        /// Count read of property
+        void addRead(SaslPropRef prop, double start);
+
+        /// Count write of numeric value
+        void countWrite(SaslPropRef prop, double value);
+
+        /// Count write of string value
+        void countWrite(SaslPropRef prop, const std::string &value);
+
+        /// Add time spent in write
+        void addWriteTime(SaslPropRef prop, double start);
+};
+
+#else
+
+/// Property access counting compiled out
+class PropsStats
+{
+    public:
+        class Read
+        {
+            public:
+                Read(PropsStats &stats, SaslPropRef prop) { };
+        };
+
+        class Write
+        {
+            public:
+                Write(PropsStats &stats, SaslPropRef prop, double value) { };
+                Write(PropsStats &stats, SaslPropRef prop, 
+                        const std::string &value) { };
+                Write(PropsStats &stats, SaslPropRef prop) { };
+        };
+
+    public:
+        void setEnabled(bool enable) { };
+        bool isEnabled() const { return false; };
+        void setName(SaslPropRef prop, const std::string &name) { };
+        void addReads(const SaslPropRef *refs, int count, double start) { };
+        double getStartTime() { return 0; };
+        void reset() { };
+        int getStats(struct SaslPropStats *stats, int maxStats) const { 
+            return 0; };
+        int dump(const char *fileName) const { return -1; };
+};
+
+#endif
+
+
+/// Register properties statistics functions in Lua
+void exportPropsStatsToLua(Luna &lua);
+
+};
+
+
+#endif
+
@@ -18,6 +18,15 @@ long RtTimer::getTime()
 {
     return GetTickCount() - startSeconds;
 }
+
+double RtTimer::getPreciseTime()
+{
+    LARGE_INTEGER frequency, counter;
+    if ((! QueryPerformanceFrequency(&frequency)) || 
+            (! QueryPerformanceCounter(&counter)))
+        return getTime();
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+}
 #else
 RtTimer::RtTimer()
 {
@@ -33,5 +42,13 @@ long RtTimer::getTime()
     int seconds = tv.tv_sec - startSeconds;
     return seconds * 1000 + tv.tv_usec / 1000;
 }
+
+double RtTimer::getPreciseTime()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int seconds = tv.tv_sec - startSeconds;
+    return seconds * 1000.0 + tv.tv_usec / 1000.0;
+}
 #endif
 
@@ -23,6 +23,10 @@ class RtTimer
     public:
         /// Returns number of milliseconds passed from timer creation
         long getTime();
+
+        /// Returns time in milliseconds with sub-millisecond precision.
+        /// Use it for measuring intervals only
+        double getPreciseTime();
 };
 
 
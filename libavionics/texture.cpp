@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include "utils.h"
 #include "luna.h"
 #include "avionics.h"
@@ -48,6 +49,7 @@ TexturePart::TexturePart(Texture *tex, double x1, double y1,
 
 TextureManager::TextureManager()
 {
+    graphics = NULL;
     buffer = NULL;
     bufLength = 0;
 }
@@ -76,12 +78,37 @@ Texture* TextureManager::loadImage(const unsigned char *buffer, int length)
     return tex;
 }
 
+Texture* TextureManager::loadImage(const DecodedImage &image)
+{
+    if (! image.pixels)
+        return NULL;
+
+    int width, height;
+    int id = graphics->load_texture_pixels(graphics, image.pixels, 
+            image.width, image.height, image.channels, &width, &height);
+    if (-1 == id)
+        return NULL;
+    
+    Texture *tex = new Texture(id, width, height, this);
+    loaded.push_back(tex);
+    return tex;
+}
+
 Texture* TextureManager::loadImage(const std::string &fileName)
 {
     TexturesMap::iterator i = cache.find(fileName);
     if (i != cache.end()) {
         return (*i).second;
     } else {
+        DecodedImage image;
+        if (decoder.take(fileName, image)) {
+            Texture *tex = loadImage(image);
+            ImageDecoder::freeImage(image);
+            if (tex)
+                cache[fileName] = tex;
+            return tex;
+        }
+
         FILE *f = fopen(fileName.c_str(), "rb");
         if (! f)
             return NULL;
@@ -272,6 +299,22 @@ TexturePart* TextureManager::addForeignTexture(int texId)
 }
 
 
+TexturePart* TextureManager::createTexture(int width, int height)
+{
+    if ((3 > graphics->version) || (! graphics->create_texture))
+        return NULL;
+
+    int id = graphics->create_texture(graphics, width, height);
+    if (-1 == id)
+        return NULL;
+
+    Texture *tex = new Texture(id, width, height, this);
+    loaded.push_back(tex);
+    // render target rows go from bottom to top
+    return getTexturePart(tex, 0, 1, 1, 0);
+}
+
+
 void TextureManager::unload(TexturePart *texturePart)
 {
     if (! texturePart)
@@ -325,6 +368,24 @@ void TextureManager::unloadAll()
         delete (*i);
     loaded.clear();
     cache.clear();
+
+    decoder.cancel();
+}
+
+bool TextureManager::preload(const std::string &fileName)
+{
+    if ((! graphics) || (5 > graphics->version) || 
+            (! graphics->load_texture_pixels))
+        return false;
+
+    if (! cache.count(fileName))
+        decoder.request(fileName);
+    return true;
+}
+
+void TextureManager::cancelPreload()
+{
+    decoder.cancel();
 }
 
 void TextureManager::setGraphicsCallbacks(struct SaslGraphicsCallbacks *callbacks)
@@ -379,6 +440,26 @@ static int luaLoadImage(lua_State *L)
     return 1;
 }
 
+/// Start decoding of image in background.  Returns true if image will
+/// be decoded or false if preloading is not supported
+static int luaPreloadImage(lua_State *L)
+{
+    TextureManager *textureManager = getAvionics(L)->getTextureManager();
+
+    const char *fileName = lua_tostring(L, 1);
+    lua_pushboolean(L, fileName && textureManager->preload(fileName));
+    return 1;
+}
+
+
+/// Forget preloaded images which are not loaded yet
+static int luaCancelImagePreload(lua_State *L)
+{
+    getAvionics(L)->getTextureManager()->cancelPreload();
+    return 0;
+}
+
+
 /// Returns size of texture in pixels
 static int luaGetTextureSize(lua_State *L)
 {
@@ -386,9 +467,9 @@ static int luaGetTextureSize(lua_State *L)
         return 0;
     TexturePart *tex = (TexturePart*)lua_touserdata(L, 1);
 
-    lua_pushnumber(L, (tex->getX2() - tex->getX1()) * 
+    lua_pushnumber(L, fabs(tex->getX2() - tex->getX1()) * 
             tex->getTexture()->getWidth());
-    lua_pushnumber(L, (tex->getY2() - tex->getY1()) * 
+    lua_pushnumber(L, fabs(tex->getY2() - tex->getY1()) * 
             tex->getTexture()->getHeight());
     return 2;
 }
@@ -521,7 +602,7 @@ static int luaSetRenderTarget(lua_State *L)
         }
     }
 
-    lua_pushboolean(L, graphics->set_render_target(graphics, texId));
+    lua_pushboolean(L, ! graphics->set_render_target(graphics, texId));
     return 1;
 }
 
@@ -539,12 +620,51 @@ static int luaRestoreRenderTarget(lua_State *L)
 
 
 
+/// Lua wrapper for creating render target texture
+static int luaCreateRenderTarget(lua_State *L)
+{
+    TextureManager *textureManager = getAvionics(L)->getTextureManager();
+
+    int width = (int)lua_tonumber(L, 1);
+    int height = (int)lua_tonumber(L, 2);
+    TexturePart *texture = NULL;
+    if ((0 < width) && (0 < height))
+        texture = textureManager->createTexture(width, height);
+
+    if (texture)
+        lua_pushlightuserdata(L, texture);
+    else
+        lua_pushnil(L);
+    return 1;
+}
+
+
+/// fill current render target with color.  transparent black by default
+static int luaClearRenderTarget(lua_State *L)
+{
+    Avionics *avionics = getAvionics(L);
+    assert(avionics);
+    SaslGraphicsCallbacks *graphics = avionics->getGraphics();
+    assert(graphics);
+
+    if ((3 > graphics->version) || (! graphics->clear_render_target))
+        return 0;
+
+    graphics->clear_render_target(graphics, lua_tonumber(L, 1),
+            lua_tonumber(L, 2), lua_tonumber(L, 3), lua_tonumber(L, 4));
+
+    return 0;
+}
+
+
 void xa::exportTextureToLua(Luna &lua)
 {
     lua_State *L = lua.getLua();
 
     lua_register(L, "getGLTexture", luaLoadImage);
     lua_register(L, "getTextureSize", luaGetTextureSize);
+    lua_register(L, "preloadImage", luaPreloadImage);
+    lua_register(L, "cancelImagePreload", luaCancelImagePreload);
     lua_register(L, "getImageSize", luaGetImageSize);
     lua_register(L, "loadImageFromMemory", luaLoadImageFromMemory);
     lua_register(L, "unloadImage", luaUnloadImage);
@@ -552,5 +672,7 @@ void xa::exportTextureToLua(Luna &lua)
     lua_register(L, "findImage", luaFindImage);
     lua_register(L, "setRenderTarget", luaSetRenderTarget);
     lua_register(L, "restoreRenderTarget", luaRestoreRenderTarget);
+    lua_register(L, "createRenderTarget", luaCreateRenderTarget);
+    lua_register(L, "clearRenderTarget", luaClearRenderTarget);
 }
 
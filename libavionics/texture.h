@@ -6,6 +6,7 @@
 #include <string>
 #include "luna.h"
 #include "libavcallbacks.h"
+#include "imagedecoder.h"
 
 namespace xa {
 
@@ -129,6 +130,9 @@ class TextureManager
         
         /// list of texture parts loaded
         PartsList partsLoaded;
+
+        /// Decodes preloaded images in background threads
+        ImageDecoder decoder;
         
     public:
         /// Create texture manager
@@ -162,6 +166,10 @@ class TextureManager
         /// Add external texture
         TexturePart* addForeignTexture(int texId);
 
+        /// Create empty texture which could be used as render target.
+        /// Returns NULL if render targets are not supported
+        TexturePart* createTexture(int width, int height);
+
         /// Unload texture from memory
         /// It is completele removes texture from memory
         /// Use it on your own risk!
@@ -170,6 +178,14 @@ class TextureManager
         /// Unload all textures
         void unloadAll();
 
+        /// Start decoding of image file in background thread.
+        /// Texture is created when image is loaded next time.
+        /// Returns false if preloading is not supported by graphics
+        bool preload(const std::string &fileName);
+
+        /// Forget preloaded images which was not loaded yet
+        void cancelPreload();
+
         /// set graphics callbacks
         void setGraphicsCallbacks(struct SaslGraphicsCallbacks *graphics);
 
@@ -183,6 +199,9 @@ class TextureManager
         /// Load image from file or return cached image if already loaded.
         Texture* loadImage(const std::string &fileName);
 
+        /// Create texture from decoded image.
+        Texture* loadImage(const DecodedImage &image);
+
         /// Returns texture coords which covers entire image
         void getPartCoords(Texture *texture, double &x1, double &y1,
                 double &x2, double &y2);
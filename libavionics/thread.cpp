@@ -0,0 +1,233 @@
+#include "thread.h"
+
+#ifndef WINDOWS
+#include <unistd.h>
+#endif
+
+
+using namespace xa;
+
+
+#ifdef WINDOWS
+
+Mutex::Mutex()
+{
+    InitializeCriticalSection(&mutex);
+}
+
+Mutex::~Mutex()
+{
+    DeleteCriticalSection(&mutex);
+}
+
+void Mutex::lock()
+{
+    EnterCriticalSection(&mutex);
+}
+
+void Mutex::unlock()
+{
+    LeaveCriticalSection(&mutex);
+}
+
+
+Condition::Condition()
+{
+    InitializeConditionVariable(&condition);
+}
+
+Condition::~Condition()
+{
+}
+
+void Condition::wait(Mutex &mutex)
+{
+    SleepConditionVariableCS(&condition, &mutex.mutex, INFINITE);
+}
+
+void Condition::signal()
+{
+    WakeConditionVariable(&condition);
+}
+
+void Condition::broadcast()
+{
+    WakeAllConditionVariable(&condition);
+}
+
+
+long AtomicInt::get()
+{
+    return InterlockedCompareExchange(&value, 0, 0);
+}
+
+void AtomicInt::set(long newValue)
+{
+    InterlockedExchange(&value, newValue);
+}
+
+long AtomicInt::exchange(long newValue)
+{
+    return InterlockedExchange(&value, newValue);
+}
+
+long AtomicInt::add(long delta)
+{
+    return InterlockedExchangeAdd(&value, delta) + delta;
+}
+
+
+DWORD WINAPI Thread::run(LPVOID thread)
+{
+    Thread *t = (Thread*)thread;
+    t->function(t->arg);
+    return 0;
+}
+
+bool Thread::start(Function function, void *arg)
+{
+    if (running)
+        return false;
+    this->function = function;
+    this->arg = arg;
+    handle = CreateThread(NULL, 0, run, this, 0, NULL);
+    running = NULL != handle;
+    return running;
+}
+
+void Thread::join()
+{
+    if (! running)
+        return;
+    WaitForSingleObject(handle, INFINITE);
+    CloseHandle(handle);
+    running = false;
+}
+
+int Thread::getProcessorsCount()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+#else
+
+Mutex::Mutex()
+{
+    pthread_mutex_init(&mutex, NULL);
+}
+
+Mutex::~Mutex()
+{
+    pthread_mutex_destroy(&mutex);
+}
+
+void Mutex::lock()
+{
+    pthread_mutex_lock(&mutex);
+}
+
+void Mutex::unlock()
+{
+    pthread_mutex_unlock(&mutex);
+}
+
+
+Condition::Condition()
+{
+    pthread_cond_init(&condition, NULL);
+}
+
+Condition::~Condition()
+{
+    pthread_cond_destroy(&condition);
+}
+
+void Condition::wait(Mutex &mutex)
+{
+    pthread_cond_wait(&condition, &mutex.mutex);
+}
+
+void Condition::signal()
+{
+    pthread_cond_signal(&condition);
+}
+
+void Condition::broadcast()
+{
+    pthread_cond_broadcast(&condition);
+}
+
+
+long AtomicInt::get()
+{
+    return __sync_fetch_and_add(&value, 0);
+}
+
+void AtomicInt::set(long newValue)
+{
+    exchange(newValue);
+}
+
+long AtomicInt::exchange(long newValue)
+{
+    // test_and_set is acquire barrier only, compare_and_swap is full one
+    long old = get();
+    for (;;) {
+        long prev = __sync_val_compare_and_swap(&value, old, newValue);
+        if (prev == old)
+            return old;
+        old = prev;
+    }
+}
+
+long AtomicInt::add(long delta)
+{
+    return __sync_add_and_fetch(&value, delta);
+}
+
+
+void* Thread::run(void *thread)
+{
+    Thread *t = (Thread*)thread;
+    t->function(t->arg);
+    return NULL;
+}
+
+bool Thread::start(Function function, void *arg)
+{
+    if (running)
+        return false;
+    this->function = function;
+    this->arg = arg;
+    running = ! pthread_create(&handle, NULL, run, this);
+    return running;
+}
+
+void Thread::join()
+{
+    if (! running)
+        return;
+    pthread_join(handle, NULL);
+    running = false;
+}
+
+int Thread::getProcessorsCount()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (0 < count) ? (int)count : 1;
+}
+
+#endif
+
+
+Thread::Thread(): running(false), function(NULL), arg(NULL)
+{
+}
+
+Thread::~Thread()
+{
+    join();
+}
+
@@ -0,0 +1,184 @@
+#ifndef __THREAD_H__
+#define __THREAD_H__
+
+
+#ifdef WINDOWS
+// condition variables require Vista or later
+#if ! defined(_WIN32_WINNT) || (_WIN32_WINNT < 0x0600)
+#undef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+
+namespace xa {
+
+
+/// Mutual exclusion lock
+class Mutex
+{
+    friend class Condition;
+
+    private:
+#ifdef WINDOWS
+        CRITICAL_SECTION mutex;
+#else
+        pthread_mutex_t mutex;
+#endif
+
+    public:
+        Mutex();
+        ~Mutex();
+
+    public:
+        /// Lock mutex.  Waits until mutex released by other threads
+        void lock();
+
+        /// Unlock mutex
+        void unlock();
+
+    private:
+        Mutex(const Mutex&);
+        Mutex& operator = (const Mutex&);
+};
+
+
+/// Locks mutex while in scope
+class MutexLock
+{
+    private:
+        Mutex &mutex;
+
+    public:
+        MutexLock(Mutex &mutex): mutex(mutex) { mutex.lock(); };
+        ~MutexLock() { mutex.unlock(); };
+
+    private:
+        MutexLock(const MutexLock&);
+        MutexLock& operator = (const MutexLock&);
+};
+
+
+/// Condition variable
+class Condition
+{
+    private:
+#ifdef WINDOWS
+        CONDITION_VARIABLE condition;
+#else
+        pthread_cond_t condition;
+#endif
+
+    public:
+        Condition();
+        ~Condition();
+
+    public:
+        /// Release mutex and wait for signal.  Mutex locked again on return
+        void wait(Mutex &mutex);
+
+        /// Wake up one waiting thread
+        void signal();
+
+        /// Wake up all waiting threads
+        void broadcast();
+
+    private:
+        Condition(const Condition&);
+        Condition& operator = (const Condition&);
+};
+
+
+/// Integer shared by threads without locks.
+/// All operations are full memory barriers
+class AtomicInt
+{
+    private:
+#ifdef WINDOWS
+        volatile LONG value;
+#else
+        volatile long value;
+#endif
+
+    public:
+        AtomicInt(long value = 0): value(value) { };
+
+    public:
+        /// Returns current value
+        long get();
+
+        /// Set new value
+        void set(long newValue);
+
+        /// Set new value.  Returns previous value
+        long exchange(long newValue);
+
+        /// Add delta to value.  Returns new value
+        long add(long delta);
+
+    private:
+        AtomicInt(const AtomicInt&);
+        AtomicInt& operator = (const AtomicInt&);
+};
+
+
+/// Thread of execution
+class Thread
+{
+    public:
+        /// Thread function
+        typedef void (*Function)(void *arg);
+
+    private:
+#ifdef WINDOWS
+        HANDLE handle;
+#else
+        pthread_t handle;
+#endif
+
+        /// True if thread was started and not joined yet
+        bool running;
+
+        /// Thread function
+        Function function;
+
+        /// Argument of thread function
+        void *arg;
+
+    public:
+        Thread();
+
+        /// Waits for thread termination
+        ~Thread();
+
+    public:
+        /// Run function in new thread.  Returns false on error
+        bool start(Function function, void *arg);
+
+        /// Wait for thread termination
+        void join();
+
+        /// Returns true if thread is started
+        bool isRunning() const { return running; };
+
+        /// Returns number of processors available
+        static int getProcessorsCount();
+
+    private:
+#ifdef WINDOWS
+        static DWORD WINAPI run(LPVOID thread);
+#else
+        static void* run(void *thread);
+#endif
+
+        Thread(const Thread&);
+        Thread& operator = (const Thread&);
+};
+
+};
+
+#endif
+
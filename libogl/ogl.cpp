@@ -241,6 +241,49 @@ static int loadTexture(struct SaslGraphicsCallbacks *canvas,
 }
 
 
+// create texture from decoded image.
+static int loadTexturePixels(struct SaslGraphicsCallbacks *canvas,
+        const unsigned char *pixels, int imageWidth, int imageHeight, 
+        int channels, int *width, int *height)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    if ((! c) || (! pixels))
+        return -1;
+
+    GLuint texId = 0;
+    if (c->genTexNameCallback)
+        texId = c->genTexNameCallback();
+
+    unsigned id = SOIL_create_OGL_texture(pixels, imageWidth, imageHeight,
+            channels, texId, SOIL_FLAG_POWER_OF_TWO);
+    if (! id)
+        return -1;
+
+    texId = id;
+
+    // because of SOIL issue
+    setTexture(c, id);
+
+    if (width) {
+        GLint w;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
+        *width = w;
+    }
+    if (height) {
+        GLint h;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
+        *height = h;
+    }
+
+    c->textures++;
+
+    if (width && height)
+        c->texturesSize += (*width) * (*height);
+
+    return texId;
+}
+
+
 // Unload texture from video memory.
 static void freeTexture(struct SaslGraphicsCallbacks *canvas, int textureId)
 {
@@ -308,6 +351,64 @@ static void drawTexturedTriangle(struct SaslGraphicsCallbacks *canvas,
 }
 
 
+// add vertex from batch
+static void addBatchVertex(OglCanvas *c, const float *vertex)
+{
+    addVertex(c, vertex[0], vertex[1],
+            vertex[4], vertex[5], vertex[6], vertex[7],
+            vertex[2], vertex[3]);
+}
+
+
+// draw batch of primitives
+static void drawVertices(struct SaslGraphicsCallbacks *canvas,
+        int mode, int textureId, const float *vertices, int count)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    if ((! c) || (! vertices) || (0 >= count))
+        return;
+
+    if (-1 == textureId)
+        disableTexture(c);
+    else
+        setTexture(c, textureId);
+
+    const int size = SASL_VERTEX_SIZE;
+    switch (mode) {
+        case SASL_PRIM_TRIANGLES:
+            setMode(c, GL_TRIANGLES);
+            count -= count % 3;
+            c->triangles += count / 3;
+            for (int i = 0; i < count; i++)
+                addBatchVertex(c, vertices + i * size);
+            break;
+
+        case SASL_PRIM_LINES:
+            setMode(c, GL_LINES);
+            count -= count % 2;
+            c->lines += count / 2;
+            for (int i = 0; i < count; i++)
+                addBatchVertex(c, vertices + i * size);
+            break;
+
+        case SASL_PRIM_QUADS:
+            setMode(c, GL_TRIANGLES);
+            count -= count % 4;
+            c->triangles += count / 2;
+            for (int i = 0; i < count; i += 4) {
+                const float *v = vertices + i * size;
+                addBatchVertex(c, v);
+                addBatchVertex(c, v + size);
+                addBatchVertex(c, v + 2 * size);
+                addBatchVertex(c, v);
+                addBatchVertex(c, v + 2 * size);
+                addBatchVertex(c, v + 3 * size);
+            }
+            break;
+    }
+}
+
+
 // enable clipping to rectangle
 static void setClipArea(struct SaslGraphicsCallbacks *canvas,
         double x, double y, double width, double height)
@@ -388,6 +489,37 @@ static void rotateTransform(struct SaslGraphicsCallbacks *canvas,
 }
 
 
+// render targets are not supported
+static int createTexture(struct SaslGraphicsCallbacks *canvas,
+        int width, int height)
+{
+    return -1;
+}
+
+
+// render targets are not supported
+static void clearRenderTarget(struct SaslGraphicsCallbacks *canvas,
+        double r, double g, double b, double a)
+{
+}
+
+
+// returns number of primitives and batches drawn since frame start
+static void getStatistics(struct SaslGraphicsCallbacks *canvas,
+        int *triangles, int *lines, int *batches)
+{
+    OglCanvas *c = (OglCanvas*)canvas;
+    assert(canvas);
+
+    if (triangles)
+        *triangles = c->triangles;
+    if (lines)
+        *lines = c->lines;
+    if (batches)
+        *batches = c->batches;
+}
+
+
 // initializa canvas structure
 struct SaslGraphicsCallbacks* saslgl_init_graphics()
 {
@@ -409,6 +541,12 @@ struct SaslGraphicsCallbacks* saslgl_init_graphics()
     c->callbacks.translate_transform = translateTransform;
     c->callbacks.scale_transform = scaleTransform;
     c->callbacks.rotate_transform = rotateTransform;
+    c->callbacks.version = SASL_GRAPHICS_VERSION;
+    c->callbacks.draw_vertices = drawVertices;
+    c->callbacks.create_texture = createTexture;
+    c->callbacks.clear_render_target = clearRenderTarget;
+    c->callbacks.get_statistics = getStatistics;
+    c->callbacks.load_texture_pixels = loadTexturePixels;
 
     c->maxVertices = 1024;
     c->vertexBuffer = (float*)malloc(sizeof(float) * 2 * c->maxVertices);
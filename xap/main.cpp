@@ -105,6 +105,12 @@ static int lastPanelHeight;
 /// reload panel hot key command
 static XPLMCommandRef reloadCommand;
 
+/// start counting of properties access command
+static XPLMCommandRef enablePropsStatsCommand;
+
+/// write properties access statistics command
+static XPLMCommandRef dumpPropsStatsCommand;
+
 /// Cockpit light red component
 static XPLMDataRef cockpitRed;
 
@@ -757,6 +763,35 @@ static int reloadPanelCallback(XPLMCommandRef command, int phase, void *data)
 }
 
 
+/// Called on start counting of properties access command
+static int enablePropsStatsCallback(XPLMCommandRef command, int phase, 
+        void *data)
+{
+    if ((xplm_CommandBegin == phase) && sasl) {
+        sasl_reset_props_stats(sasl);
+        sasl_enable_props_stats(sasl, 1);
+    }
+    return 1;
+}
+
+
+/// Called on write properties access statistics command.
+/// Statistics is written to sasl_props_stats.csv in X-Plane directory
+static int dumpPropsStatsCallback(XPLMCommandRef command, int phase, 
+        void *data)
+{
+    if ((xplm_CommandBegin == phase) && sasl) {
+        char buf[512];
+        XPLMGetSystemPath(buf);
+        std::string fileName = carbonPathToPosixPath(std::string(buf)) + 
+            "sasl_props_stats.csv";
+        if (sasl_dump_props_stats(sasl, fileName.c_str()))
+            XPLMDebugString("SASL: Can't write properties statistics\n");
+    }
+    return 1;
+}
+
+
 // returns true if view changed since last function call
 static bool isViewTheSame()
 {
@@ -932,6 +967,10 @@ PLUGIN_API void	XPluginStop(void)
 PLUGIN_API void XPluginDisable(void)
 {
     XPLMUnregisterCommandHandler(reloadCommand, reloadPanelCallback, 0, NULL);
+    XPLMUnregisterCommandHandler(enablePropsStatsCommand, 
+            enablePropsStatsCallback, 0, NULL);
+    XPLMUnregisterCommandHandler(dumpPropsStatsCommand, 
+            dumpPropsStatsCallback, 0, NULL);
     XPLMUnregisterFlightLoopCallback(updateAvionics, NULL);
     XPLMUnregisterKeySniffer(handleKeyboardEvent, 0, NULL);
     disabled = true;
@@ -964,6 +1003,15 @@ PLUGIN_API int XPluginEnable(void)
     reloadCommand = XPLMCreateCommand("sasl/reload", "Reload SASL avionics");
     XPLMRegisterCommandHandler(reloadCommand, reloadPanelCallback, 0, NULL);
 
+    enablePropsStatsCommand = XPLMCreateCommand("sasl/enable_props_stats", 
+            "Start counting SASL properties access");
+    XPLMRegisterCommandHandler(enablePropsStatsCommand, 
+            enablePropsStatsCallback, 0, NULL);
+    dumpPropsStatsCommand = XPLMCreateCommand("sasl/dump_props_stats", 
+            "Write SASL properties access statistics to CSV file");
+    XPLMRegisterCommandHandler(dumpPropsStatsCommand, 
+            dumpPropsStatsCallback, 0, NULL);
+
     XPLMRegisterKeySniffer(handleKeyboardEvent, 0, NULL);
     
     reloadPanel(false);
@@ -1,6 +1,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -17,9 +18,24 @@ using namespace xap;
 
 
 struct XPlaneProps;
+struct Property;
 
 
-/// Reference to X-Plane property 
+/// Functions which reads and writes property as value of type T.
+/// They are selected by property type when reference is created
+/// so access doesn't require checking of property type
+template <typename T>
+struct Accessors {
+    /// Returns value of property
+    T (*get)(Property *prop, int *err);
+
+    /// Sets value of property.  Returns zero on success
+    int (*set)(Property *prop, T value);
+};
+
+
+/// Reference to X-Plane property.
+/// References are shared between all users of the same property
 struct Property {
     /// X-Plane property reference
     XPLMDataRef ref;
@@ -29,9 +45,35 @@ struct Property {
 
     /// Link to properties structure
     XPlaneProps *parent;
+
+    /// Number of users of reference
+    int refCount;
+
+    /// Names under which property is registered in names index
+    std::vector<std::string> names;
+
+    /// X-Plane type of property or xplmType_Unknown if property
+    /// is not registered yet
+    XPLMDataTypeID type;
+
+    /// True if property is writable
+    bool writable;
+
+    /// Access to property as integer
+    Accessors<int> ints;
+
+    /// Access to property as float
+    Accessors<float> floats;
+
+    /// Access to property as double
+    Accessors<double> doubles;
 };
 
 
+/// Find type of property and select accessors
+static void resolveType(Property *prop);
+
+
 /// Value of property
 struct Value {
     /// Property as int
@@ -76,8 +118,14 @@ struct FuncProperty
 };
 
 
-/// List of referneces to properties
-typedef std::list<Property*> PropsList;
+/// X-Plane property and index in array
+typedef std::pair<XPLMDataRef, int> PropKey;
+
+/// References to properties mapped by X-Plane reference and index
+typedef std::map<PropKey, Property*> PropsMap;
+
+/// References to properties mapped by name used for search
+typedef std::map<std::string, Property*> PropsNames;
 
 
 /// List of self-created properties
@@ -88,6 +136,13 @@ typedef std::list<FuncProperty*> FuncPropsList;
 
 
 
+/// Type of delayed write of int array elements
+#define SET_INT_ARRAY 101
+
+/// Type of delayed write of float array elements
+#define SET_FLOAT_ARRAY 102
+
+
 /// delayed set property value command
 struct SetPropCmd
 {
@@ -99,6 +154,15 @@ struct SetPropCmd
 
     /// value to set
     Value data;
+
+    /// index of first array element to set
+    int offset;
+
+    /// array elements to set
+    std::vector<int> ints;
+
+    /// array elements to set
+    std::vector<float> floats;
     
     SetPropCmd(Property *prop, int value) {
         property = prop;
@@ -123,6 +187,22 @@ struct SetPropCmd
         type = PROP_STRING;
         data.stringValue = value;
     };
+
+    SetPropCmd(Property *prop, int offset, int count, const int *values):
+        ints(values, values + count)
+    {
+        property = prop;
+        type = SET_INT_ARRAY;
+        this->offset = offset;
+    };
+
+    SetPropCmd(Property *prop, int offset, int count, const float *values):
+        floats(values, values + count)
+    {
+        property = prop;
+        type = SET_FLOAT_ARRAY;
+        this->offset = offset;
+    };
 };
 
 /// List of set prop commands
@@ -132,7 +212,11 @@ typedef std::list<struct SetPropCmd> PropsToSet;
 /// X-Plane properties info
 struct XPlaneProps {
     /// References to properties
-    PropsList props;
+    PropsMap props;
+
+    /// References to properties by names.  Each reference could be
+    /// found by several names, e.g. "array" and "array[0]"
+    PropsNames names;
 
     /// user created properties
     CustomPropsMap customProps;
@@ -164,8 +248,8 @@ void xap::propsDone(SaslProps props)
     if (! p)
         return;
 
-    for (PropsList::iterator i = p->props.begin(); i != p->props.end(); ++i)
-        delete *i;
+    for (PropsMap::iterator i = p->props.begin(); i != p->props.end(); ++i)
+        delete (*i).second;
     
     for (FuncPropsList::iterator i = p->funcProps.begin(); 
             i != p->funcProps.end(); ++i)
@@ -198,6 +282,277 @@ void xap::funcPropsDone(SaslProps props)
         delete *i;
     }
     p->funcProps.clear();
+
+    // functional properties will be registered again, so names should
+    // be searched again too
+    p->names.clear();
+
+    // types of properties could change on registration
+    for (PropsMap::iterator i = p->props.begin(); i != p->props.end(); ++i) {
+        (*i).second->names.clear();
+        resolveType((*i).second);
+    }
+}
+
+
+/// Convert string value of property to number
+static void fromString(const char *str, int &value)
+{
+    value = strToInt(str);
+}
+
+static void fromString(const char *str, float &value)
+{
+    value = strToFloat(str);
+}
+
+static void fromString(const char *str, double &value)
+{
+    value = strToDouble(str);
+}
+
+
+/// Returns accessors of property for values of type T
+static Accessors<int>& getAccessors(Property *prop, int*)
+{
+    return prop->ints;
+}
+
+static Accessors<float>& getAccessors(Property *prop, float*)
+{
+    return prop->floats;
+}
+
+static Accessors<double>& getAccessors(Property *prop, double*)
+{
+    return prop->doubles;
+}
+
+
+/// Read int property
+template <typename T>
+static T readInt(Property *prop, int *err)
+{
+    return (T)XPLMGetDatai(prop->ref);
+}
+
+/// Read float property
+template <typename T>
+static T readFloat(Property *prop, int *err)
+{
+    return (T)XPLMGetDataf(prop->ref);
+}
+
+/// Read double property
+template <typename T>
+static T readDouble(Property *prop, int *err)
+{
+    return (T)XPLMGetDatad(prop->ref);
+}
+
+/// Read element of int array property
+template <typename T>
+static T readIntArray(Property *prop, int *err)
+{
+    int val = 0;
+    XPLMGetDatavi(prop->ref, &val, prop->index, 1);
+    return (T)val;
+}
+
+/// Read element of float array property
+template <typename T>
+static T readFloatArray(Property *prop, int *err)
+{
+    float val = 0;
+    XPLMGetDatavf(prop->ref, &val, prop->index, 1);
+    return (T)val;
+}
+
+/// Read data property and convert it to number
+template <typename T>
+static T readData(Property *prop, int *err)
+{
+    int len = XPLMGetDatab(prop->ref, NULL, 0, 0);
+    if (0 >= len)
+        return 0;
+#ifdef WINDOWS
+    char *buf = (char*)alloca(len + 1);
+#else
+    char buf[len + 1];
+#endif
+    XPLMGetDatab(prop->ref, buf, 0, len);
+    buf[len] = 0;
+    T value;
+    fromString(buf, value);
+    return value;
+}
+
+/// Read property which type is not known yet
+template <typename T>
+static T readUnknown(Property *prop, int *err)
+{
+    resolveType(prop);
+    if (xplmType_Unknown == prop->type) {
+        if (err)
+            *err = 1;
+        return 0;
+    }
+    return getAccessors(prop, (T*)NULL).get(prop, err);
+}
+
+
+/// Write int property
+template <typename T>
+static int writeInt(Property *prop, T value)
+{
+    XPLMSetDatai(prop->ref, (int)value);
+    return 0;
+}
+
+/// Write float property
+template <typename T>
+static int writeFloat(Property *prop, T value)
+{
+    XPLMSetDataf(prop->ref, (float)value);
+    return 0;
+}
+
+/// Write double property
+template <typename T>
+static int writeDouble(Property *prop, T value)
+{
+    XPLMSetDatad(prop->ref, (double)value);
+    return 0;
+}
+
+/// Write element of int array property
+template <typename T>
+static int writeIntArray(Property *prop, T value)
+{
+    int val = (int)value;
+    XPLMSetDatavi(prop->ref, &val, prop->index, 1);
+    return 0;
+}
+
+/// Write element of float array property
+template <typename T>
+static int writeFloatArray(Property *prop, T value)
+{
+    float val = (float)value;
+    XPLMSetDatavf(prop->ref, &val, prop->index, 1);
+    return 0;
+}
+
+/// Convert number to string and write it to data property
+template <typename T>
+static int writeData(Property *prop, T value)
+{
+    std::string s = toString(value);
+    XPLMSetDatab(prop->ref, (void*)s.c_str(), 0, s.length() + 1);
+    return 0;
+}
+
+/// Write to read-only property
+template <typename T>
+static int writeReadOnly(Property *prop, T value)
+{
+    return -1;
+}
+
+/// Write property which type is not known yet
+template <typename T>
+static int writeUnknown(Property *prop, T value)
+{
+    resolveType(prop);
+    if (xplmType_Unknown == prop->type)
+        return -2;
+    return getAccessors(prop, (T*)NULL).set(prop, value);
+}
+
+
+/// Preferred source types for reading and writing integers
+static const XPLMDataTypeID intSources[] = { xplmType_Int, xplmType_Float,
+    xplmType_Double, xplmType_IntArray, xplmType_FloatArray, xplmType_Data, 
+    0 };
+
+/// Preferred source types for reading and writing floats
+static const XPLMDataTypeID floatSources[] = { xplmType_Float, xplmType_Int,
+    xplmType_Double, xplmType_FloatArray, xplmType_IntArray, xplmType_Data, 
+    0 };
+
+/// Preferred source types for reading and writing doubles
+static const XPLMDataTypeID doubleSources[] = { xplmType_Double, 
+    xplmType_Float, xplmType_Int, xplmType_FloatArray, xplmType_IntArray, 
+    xplmType_Data, 0 };
+
+
+/// Select accessors for values of type T.
+/// Properties could have several types, first matching type from 
+/// sources list is used
+template <typename T>
+static void selectAccessors(Property *prop, const XPLMDataTypeID *sources)
+{
+    XPLMDataTypeID source = xplmType_Unknown;
+    for (int i = 0; sources[i]; i++)
+        if (sources[i] & prop->type) {
+            source = sources[i];
+            break;
+        }
+
+    Accessors<T> &access = getAccessors(prop, (T*)NULL);
+    switch (source) {
+        case xplmType_Int: 
+            access.get = readInt<T>;
+            access.set = writeInt<T>;
+            break;
+        case xplmType_Float: 
+            access.get = readFloat<T>;
+            access.set = writeFloat<T>;
+            break;
+        case xplmType_Double: 
+            access.get = readDouble<T>;
+            access.set = writeDouble<T>;
+            break;
+        case xplmType_IntArray: 
+            access.get = readIntArray<T>;
+            access.set = writeIntArray<T>;
+            break;
+        case xplmType_FloatArray: 
+            access.get = readFloatArray<T>;
+            access.set = writeFloatArray<T>;
+            break;
+        case xplmType_Data: 
+            access.get = readData<T>;
+            access.set = writeData<T>;
+            break;
+        default:
+            access.get = readUnknown<T>;
+            access.set = writeUnknown<T>;
+            return;
+    }
+
+    if (! prop->writable)
+        access.set = writeReadOnly<T>;
+}
+
+
+/// Accessors for unknown type try to resolve type again on each call
+static void resolveType(Property *prop)
+{
+    prop->type = XPLMGetDataRefTypes(prop->ref);
+    prop->writable = XPLMCanWriteDataRef(prop->ref);
+    selectAccessors<int>(prop, intSources);
+    selectAccessors<float>(prop, floatSources);
+    selectAccessors<double>(prop, doubleSources);
+}
+
+
+/// Returns type of property.  Tries to resolve type if it is unknown
+static XPLMDataTypeID getType(Property *prop)
+{
+    if (xplmType_Unknown == prop->type)
+        resolveType(prop);
+    return prop->type;
 }
 
 
@@ -210,7 +565,7 @@ static void cutArrayIndex(std::string &name, int &index)
     if (std::string::npos == firstIdx)
         return;
     
-    size_t lastIdx = name.find_first_of('[', firstIdx);
+    size_t lastIdx = name.find_first_of(']', firstIdx);
     if (std::string::npos == lastIdx)
         return; // invalid index
 
@@ -220,13 +575,21 @@ static void cutArrayIndex(std::string &name, int &index)
 }
 
 
-/// Finds reference to property
+/// Finds reference to property.
+/// All searches of the same property returns the same reference
 static SaslPropRef getPropRef(SaslProps props, const char *name, int type)
 {
     XPlaneProps *p = (XPlaneProps*)props;
     if (! (p && name))
         return NULL;
 
+    PropsNames::iterator i = p->names.find(name);
+    if (i != p->names.end()) {
+        Property *prop = (*i).second;
+        prop->refCount++;
+        return prop;
+    }
+
     int index = 0;
     XPLMDataRef ref = XPLMFindDataRef(name);
 
@@ -239,11 +602,22 @@ static SaslPropRef getPropRef(SaslProps props, const char *name, int type)
             return NULL;
     }
 
-    Property *prop = new Property;
-    prop->ref = ref;
-    prop->index = index;
-    prop->parent = p;
-    p->props.push_back(prop);
+    Property *prop;
+    PropsMap::iterator j = p->props.find(PropKey(ref, index));
+    if (j != p->props.end()) {
+        prop = (*j).second;
+        prop->refCount++;
+    } else {
+        prop = new Property;
+        prop->ref = ref;
+        prop->index = index;
+        prop->parent = p;
+        prop->refCount = 1;
+        resolveType(prop);
+        p->props[PropKey(ref, index)] = prop;
+    }
+    p->names[name] = prop;
+    prop->names.push_back(name);
     return prop;
 }
 
@@ -259,12 +633,20 @@ static void freePropRef(SaslPropRef property)
     if (! p)
         return;
 
-    for (PropsList::iterator i = p->props.begin(); i != p->props.end(); ++i)
-        if ((*i) == (Property*)prop) {
-            p->props.erase(i);
-            delete prop;
-            return;
-        }
+    prop->refCount--;
+    if (0 < prop->refCount)
+        return;
+
+    // name could be taken by another property after reload
+    for (std::vector<std::string>::const_iterator i = prop->names.begin();
+            i != prop->names.end(); i++)
+    {
+        PropsNames::iterator j = p->names.find(*i);
+        if ((j != p->names.end()) && ((*j).second == prop))
+            p->names.erase(j);
+    }
+    p->props.erase(PropKey(prop->ref, prop->index));
+    delete prop;
 }
 
 
@@ -281,48 +663,7 @@ static int getPropInt(SaslPropRef property, int *err)
         return 0;
     }
 
-    XPLMDataTypeID type = XPLMGetDataRefTypes(prop->ref);
-
-    if (xplmType_Int & type)
-        return XPLMGetDatai(prop->ref);
-    
-    if (xplmType_Float & type)
-        return (int)XPLMGetDataf(prop->ref);
-    
-    if (xplmType_Double & type)
-        return (int)XPLMGetDatad(prop->ref);
-
-    if (xplmType_IntArray & type) {
-        int val = 0;
-        XPLMGetDatavi(prop->ref, &val, prop->index, 1);
-        return val;
-    }
-    
-    if (xplmType_FloatArray & type) {
-        float val = 0;
-        XPLMGetDatavf(prop->ref, &val, prop->index, 1);
-        return (int)val;
-    }
-
-    if (xplmType_Data & type) {
-        int len = XPLMGetDatab(prop->ref, NULL, 0, 0);
-        if (0 < len) {
-#ifdef WINDOWS
-            char *buf = (char*)alloca(len + 1);
-#else
-            char buf[len + 1];
-#endif
-            XPLMGetDatab(prop->ref, buf, 0, len);
-            buf[len] = 0;
-            return strToInt(buf);
-        } else
-            return 0;
-    }
-
-    if (err)
-        *err = 1;
-
-    return 0;
+    return prop->ints.get(prop, err);
 }
 
 
@@ -338,44 +679,7 @@ static int setPropInt(SaslPropRef property, int value)
     if (! props->initialized) 
         props->propsToSet.push_back(SetPropCmd(prop, value));
 
-    if (! XPLMCanWriteDataRef(prop->ref))
-        return -1;
-
-    XPLMDataTypeID type = XPLMGetDataRefTypes(prop->ref);
-
-    if (xplmType_Int & type) {
-        XPLMSetDatai(prop->ref, value);
-        return 0;
-    }
-    
-    if (xplmType_Float & type) {
-        XPLMSetDataf(prop->ref, (float)value);
-        return 0;
-    }
-    
-    if (xplmType_Double & type) {
-        XPLMSetDatad(prop->ref, (double)value);
-        return 0;
-    }
-
-    if (xplmType_IntArray & type) {
-        XPLMSetDatavi(prop->ref, &value, prop->index, 1);
-        return 0;
-    }
-    
-    if (xplmType_FloatArray & type) {
-        float val = value;
-        XPLMSetDatavf(prop->ref, &val, prop->index, 1);
-        return 0;
-    }
-
-    if (xplmType_Data & type) {
-        std::string s = toString(value);
-        XPLMSetDatab(prop->ref, (void*)s.c_str(), 0, s.length() + 1);
-        return 0;
-    }
-
-    return -2;
+    return prop->ints.set(prop, value);
 }
 
 
@@ -392,48 +696,7 @@ static float getPropFloat(SaslPropRef property, int *err)
         return 0;
     }
 
-    XPLMDataTypeID type = XPLMGetDataRefTypes(prop->ref);
-
-    if (xplmType_Float & type)
-        return XPLMGetDataf(prop->ref);
-    
-    if (xplmType_Int & type)
-        return XPLMGetDatai(prop->ref);
-    
-    if (xplmType_Double & type)
-        return (float)XPLMGetDatad(prop->ref);
-
-    if (xplmType_FloatArray & type) {
-        float val = 0;
-        XPLMGetDatavf(prop->ref, &val, prop->index, 1);
-        return val;
-    }
-
-    if (xplmType_IntArray & type) {
-        int val = 0;
-        XPLMGetDatavi(prop->ref, &val, prop->index, 1);
-        return val;
-    }
-    
-    if (xplmType_Data & type) {
-        int len = XPLMGetDatab(prop->ref, NULL, 0, 0);
-        if (0 < len) {
-#ifdef WINDOWS
-            char *buf = (char*)alloca(len + 1);
-#else
-            char buf[len + 1];
-#endif
-            XPLMGetDatab(prop->ref, buf, 0, len);
-            buf[len] = 0;
-            return strToFloat(buf);
-        } else
-            return 0;
-    }
-    
-    if (err)
-        *err = 1;
-
-    return 0;
+    return prop->floats.get(prop, err);
 }
 
 
@@ -449,44 +712,7 @@ static int setPropFloat(SaslPropRef property, float value)
     if (! props->initialized) 
         props->propsToSet.push_back(SetPropCmd(prop, value));
 
-    if (! XPLMCanWriteDataRef(prop->ref))
-        return -1;
-
-    XPLMDataTypeID type = XPLMGetDataRefTypes(prop->ref);
-
-    if (xplmType_Float & type) {
-        XPLMSetDataf(prop->ref, value);
-        return 0;
-    }
-    
-    if (xplmType_Int & type) {
-        XPLMSetDatai(prop->ref, (int)value);
-        return 0;
-    }
-    
-    if (xplmType_Double & type) {
-        XPLMSetDatad(prop->ref, (double)value);
-        return 0;
-    }
-
-    if (xplmType_FloatArray & type) {
-        XPLMSetDatavf(prop->ref, &value, prop->index, 1);
-        return 0;
-    }
-
-    if (xplmType_IntArray & type) {
-        int val = (int)value;
-        XPLMSetDatavi(prop->ref, &val, prop->index, 1);
-        return 0;
-    }
-
-    if (xplmType_Data & type) {
-        std::string s = toString(value);
-        XPLMSetDatab(prop->ref, (void*)s.c_str(), 0, s.length() + 1);
-        return 0;
-    }
-    
-    return -2;
+    return prop->floats.set(prop, value);
 }
 
 /// Returne value of property as double
@@ -502,48 +728,7 @@ static double getPropDouble(SaslPropRef property, int *err)
         return 0;
     }
 
-    XPLMDataTypeID type = XPLMGetDataRefTypes(prop->ref);
-
-    if (xplmType_Double & type)
-        return (float)XPLMGetDatad(prop->ref);
-
-    if (xplmType_Float & type)
-        return XPLMGetDataf(prop->ref);
-    
-    if (xplmType_Int & type)
-        return XPLMGetDatai(prop->ref);
-    
-    if (xplmType_FloatArray & type) {
-        float val = 0;
-        XPLMGetDatavf(prop->ref, &val, prop->index, 1);
-        return val;
-    }
-
-    if (xplmType_IntArray & type) {
-        int val = 0;
-        XPLMGetDatavi(prop->ref, &val, prop->index, 1);
-        return val;
-    }
-    
-    if (xplmType_Data & type) {
-        int len = XPLMGetDatab(prop->ref, NULL, 0, 0);
-        if (0 < len) {
-#ifdef WINDOWS
-            char *buf = (char*)alloca(len + 1);
-#else
-            char buf[len + 1];
-#endif
-            XPLMGetDatab(prop->ref, buf, 0, len);
-            buf[len] = 0;
-            return strToDouble(buf);
-        } else
-            return 0;
-    }
-    
-    if (err)
-        *err = 1;
-
-    return 0;
+    return prop->doubles.get(prop, err);
 }
 
 
@@ -559,60 +744,39 @@ static int setPropDouble(SaslPropRef property, double value)
     if (! props->initialized) 
         props->propsToSet.push_back(SetPropCmd(prop, value));
 
-    if (! XPLMCanWriteDataRef(prop->ref))
-        return -1;
-
-    XPLMDataTypeID type = XPLMGetDataRefTypes(prop->ref);
+    return prop->doubles.set(prop, value);
+}
 
-    if (xplmType_Double & type) {
-        XPLMSetDatad(prop->ref, value);
-        return 0;
-    }
 
-    if (xplmType_Float & type) {
-        XPLMSetDataf(prop->ref, (float)value);
-        return 0;
-    }
-    
-    if (xplmType_Int & type) {
-        XPLMSetDatai(prop->ref, (int)value);
-        return 0;
-    }
-    
-    if (xplmType_FloatArray & type) {
-        float val = (float)value;
-        XPLMSetDatavf(prop->ref, &val, prop->index, 1);
-        return 0;
+/// Copy string to buffer truncating it if buffer is too small.
+/// Returns length of source string
+static int copyStr(char *dest, int maxSize, const char *src)
+{
+    int len = strlen(src);
+    if (dest && (0 < maxSize)) {
+        int toCopy = len < maxSize ? len : maxSize - 1;
+        memcpy(dest, src, toCopy);
+        dest[toCopy] = 0;
     }
+    return len;
+}
 
-    if (xplmType_IntArray & type) {
-        int val = (int)value;
-        XPLMSetDatavi(prop->ref, &val, prop->index, 1);
-        return 0;
-    }
 
-    if (xplmType_Data & type) {
-        std::string s = toString(value);
-        XPLMSetDatab(prop->ref, (void*)s.c_str(), 0, s.length() + 1);
-        return 0;
-    }
-    
-    return -2;
+/// Print number to buffer.  Returns length of string
+static int printNumber(char *dest, int maxSize, double value)
+{
+    char str[32];
+    sprintf(str, "%g", value);
+    return copyStr(dest, maxSize, str);
 }
 
 
-static int copyStr(char *dest, int maxSize, const std::string &src, int *err)
+/// Print number to buffer.  Returns length of string
+static int printNumber(char *dest, int maxSize, int value)
 {
-    int len = src.length();
-    if (dest && maxSize) {
-        int flen = len + 1;
-        int toCopy = flen < maxSize ? flen : maxSize;
-        memcpy(dest, src.c_str(), toCopy);
-        dest[toCopy - 1] = 0;
-        if ((flen < maxSize) && (err))
-            *err = 1;
-    }
-    return src.length();
+    char str[32];
+    sprintf(str, "%i", value);
+    return copyStr(dest, maxSize, str);
 }
 
 
@@ -630,11 +794,11 @@ static int getPropString(SaslPropRef property, char *buf, int maxSize, int *err)
         return 0;
     }
 
-    XPLMDataTypeID type = XPLMGetDataRefTypes(prop->ref);
+    XPLMDataTypeID type = getType(prop);
     
     if (xplmType_Data & type) {
         int sz = XPLMGetDatab(prop->ref, NULL, 0, 0);
-        if (buf) {
+        if (buf && (0 < maxSize)) {
             int res = XPLMGetDatab(prop->ref, buf, 0, maxSize);
             if (res < maxSize)
                 buf[res] = 0;
@@ -645,24 +809,24 @@ static int getPropString(SaslPropRef property, char *buf, int maxSize, int *err)
     }
     
     if (xplmType_Double & type)
-        return copyStr(buf, maxSize, toString(XPLMGetDatad(prop->ref)), err);
+        return printNumber(buf, maxSize, XPLMGetDatad(prop->ref));
 
     if (xplmType_Float & type)
-        return copyStr(buf, maxSize, toString(XPLMGetDataf(prop->ref)), err);
+        return printNumber(buf, maxSize, (double)XPLMGetDataf(prop->ref));
     
     if (xplmType_Int & type)
-        return copyStr(buf, maxSize, toString(XPLMGetDatai(prop->ref)), err);
+        return printNumber(buf, maxSize, XPLMGetDatai(prop->ref));
     
     if (xplmType_FloatArray & type) {
         float val = 0;
         XPLMGetDatavf(prop->ref, &val, prop->index, 1);
-        return copyStr(buf, maxSize, toString(val), err);
+        return printNumber(buf, maxSize, (double)val);
     }
 
     if (xplmType_IntArray & type) {
         int val = 0;
         XPLMGetDatavi(prop->ref, &val, prop->index, 1);
-        return copyStr(buf, maxSize, toString(val), err);
+        return printNumber(buf, maxSize, val);
     }
     
     if (err)
@@ -684,11 +848,10 @@ static int setPropString(SaslPropRef property, const char *value)
     if (! props->initialized) 
         props->propsToSet.push_back(SetPropCmd(prop, value));
 
-    if (! XPLMCanWriteDataRef(prop->ref))
+    XPLMDataTypeID type = getType(prop);
+    if ((xplmType_Unknown != type) && (! prop->writable))
         return -1;
 
-    XPLMDataTypeID type = XPLMGetDataRefTypes(prop->ref);
-
     if (xplmType_Data & type) {
         XPLMSetDatab(prop->ref, (void*)value, 0, strlen(value) + 1);
         return 0;
@@ -725,6 +888,233 @@ static int setPropString(SaslPropRef property, const char *value)
 }
 
 
+/// Number of array elements converted at once
+#define ARRAY_CHUNK 64
+
+
+/// Types of X-Plane arrays for elements of type T
+template <typename T>
+struct ArrayTraits;
+
+template <>
+struct ArrayTraits<int> {
+    /// Type of elements of other kind of arrays
+    typedef float Other;
+
+    /// Array which stores elements of type T
+    static const XPLMDataTypeID type = xplmType_IntArray;
+
+    /// Array which requires conversion
+    static const XPLMDataTypeID otherType = xplmType_FloatArray;
+};
+
+template <>
+struct ArrayTraits<float> {
+    /// Type of elements of other kind of arrays
+    typedef int Other;
+
+    /// Array which stores elements of type T
+    static const XPLMDataTypeID type = xplmType_FloatArray;
+
+    /// Array which requires conversion
+    static const XPLMDataTypeID otherType = xplmType_IntArray;
+};
+
+
+/// Read elements of X-Plane array
+static int getArray(XPLMDataRef ref, int *values, int offset, int count)
+{
+    return XPLMGetDatavi(ref, values, offset, count);
+}
+
+static int getArray(XPLMDataRef ref, float *values, int offset, int count)
+{
+    return XPLMGetDatavf(ref, values, offset, count);
+}
+
+
+/// Write elements of X-Plane array
+static void setArray(XPLMDataRef ref, const int *values, int offset, 
+        int count)
+{
+    XPLMSetDatavi(ref, (int*)values, offset, count);
+}
+
+static void setArray(XPLMDataRef ref, const float *values, int offset, 
+        int count)
+{
+    XPLMSetDatavf(ref, (float*)values, offset, count);
+}
+
+
+/// Read elements of array of type S and convert them to type T
+template <typename T, typename S>
+static int readConverted(XPLMDataRef ref, int offset, int count, T *values)
+{
+    S buf[ARRAY_CHUNK];
+    int done = 0;
+    while (done < count) {
+        int n = count - done;
+        if (n > ARRAY_CHUNK)
+            n = ARRAY_CHUNK;
+        int read = getArray(ref, buf, offset + done, n);
+        for (int i = 0; i < read; i++)
+            values[done + i] = (T)buf[i];
+        done += read;
+        if (read < n)
+            break;
+    }
+    return done;
+}
+
+
+/// Convert values to type S and write them to array of type S
+template <typename T, typename S>
+static void writeConverted(XPLMDataRef ref, int offset, int count, 
+        const T *values)
+{
+    S buf[ARRAY_CHUNK];
+    for (int done = 0; done < count; done += ARRAY_CHUNK) {
+        int n = count - done;
+        if (n > ARRAY_CHUNK)
+            n = ARRAY_CHUNK;
+        for (int i = 0; i < n; i++)
+            buf[i] = (S)values[done + i];
+        setArray(ref, buf, offset + done, n);
+    }
+}
+
+
+/// Read elements of array property.
+/// Returns number of elements read or -1 on error
+template <typename T>
+static int readArray(Property *prop, int offset, int count, T *values)
+{
+    if ((! prop) || (! values) || (0 > offset) || (0 > count))
+        return -1;
+
+    XPLMDataTypeID type = getType(prop);
+
+    if (ArrayTraits<T>::type & type)
+        return getArray(prop->ref, values, offset, count);
+
+    if (ArrayTraits<T>::otherType & type)
+        return readConverted<T, typename ArrayTraits<T>::Other>(prop->ref, 
+                offset, count, values);
+
+    if ((xplmType_Int | xplmType_Float | xplmType_Double) & type) {
+        if (offset || (! count))
+            return 0;
+        int err = 0;
+        values[0] = getAccessors(prop, (T*)NULL).get(prop, &err);
+        return err ? -1 : 1;
+    }
+
+    return -1;
+}
+
+
+/// Write elements of array property.
+/// Returns zero on success or non-zero on error
+template <typename T>
+static int writeArray(Property *prop, int offset, int count, const T *values)
+{
+    if ((! prop) || (! values) || (0 > offset) || (0 > count))
+        return -1;
+
+    XPLMDataTypeID type = getType(prop);
+    if (! prop->writable)
+        return -1;
+
+    if (ArrayTraits<T>::type & type) {
+        setArray(prop->ref, values, offset, count);
+        return 0;
+    }
+
+    if (ArrayTraits<T>::otherType & type) {
+        writeConverted<T, typename ArrayTraits<T>::Other>(prop->ref, 
+                offset, count, values);
+        return 0;
+    }
+
+    if ((xplmType_Int | xplmType_Float | xplmType_Double) & type) {
+        if (offset || (1 != count))
+            return -2;
+        return getAccessors(prop, (T*)NULL).set(prop, values[0]);
+    }
+
+    return -2;
+}
+
+
+/// Read elements of array property as integers
+static int getPropArrayInt(SaslPropRef property, int offset, int count, 
+        int *values)
+{
+    return readArray((Property*)property, offset, count, values);
+}
+
+
+/// Write elements of array property as integers
+static int setPropArrayInt(SaslPropRef property, int offset, int count, 
+        const int *values)
+{
+    Property *prop = (Property*)property;
+    if ((! prop) || (! values) || (0 > count))
+        return -1;
+
+    XPlaneProps *props = prop->parent;
+    if (! props->initialized) 
+        props->propsToSet.push_back(SetPropCmd(prop, offset, count, values));
+
+    return writeArray(prop, offset, count, values);
+}
+
+
+/// Read elements of array property as floats
+static int getPropArrayFloat(SaslPropRef property, int offset, int count, 
+        float *values)
+{
+    return readArray((Property*)property, offset, count, values);
+}
+
+
+/// Write elements of array property as floats
+static int setPropArrayFloat(SaslPropRef property, int offset, int count, 
+        const float *values)
+{
+    Property *prop = (Property*)property;
+    if ((! prop) || (! values) || (0 > count))
+        return -1;
+
+    XPlaneProps *props = prop->parent;
+    if (! props->initialized) 
+        props->propsToSet.push_back(SetPropCmd(prop, offset, count, values));
+
+    return writeArray(prop, offset, count, values);
+}
+
+
+/// Read values of group of properties as doubles
+static int getPropsDouble(const SaslPropRef *refs, int count, double *values)
+{
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        Property *prop = (Property*)refs[i];
+        int err = 0;
+        if (prop)
+            values[i] = prop->doubles.get(prop, &err);
+        else
+            err = 1;
+        if (err) {
+            values[i] = 0;
+            failed++;
+        }
+    }
+    return failed;
+}
+
+
 /// Returns value of custom int property
 static int readInt(void *refcon)
 {
@@ -926,6 +1316,16 @@ static int updateProps(SaslProps props)
                 case PROP_FLOAT: setPropFloat(v.property, v.data.floatValue); break;
                 case PROP_DOUBLE: setPropDouble(v.property, v.data.doubleValue); break;
                 case PROP_STRING: setPropString(v.property, v.data.stringValue.c_str()); break;
+                case SET_INT_ARRAY: 
+                    if (! v.ints.empty())
+                        setPropArrayInt(v.property, v.offset, v.ints.size(), 
+                                &v.ints[0]); 
+                    break;
+                case SET_FLOAT_ARRAY: 
+                    if (! v.floats.empty())
+                        setPropArrayFloat(v.property, v.offset, 
+                                v.floats.size(), &v.floats[0]); 
+                    break;
             }
         }
         p->propsToSet.clear();
@@ -1096,7 +1496,8 @@ static SaslPropRef createFuncProp(SaslProps props, const char *name,
 static SaslPropsCallbacks callbacks = { getPropRef, freePropRef, createProp, 
         createFuncProp, getPropInt, setPropInt, getPropFloat, 
         setPropFloat, getPropDouble, setPropDouble, getPropString,
-        setPropString, updateProps, NULL };
+        setPropString, updateProps, NULL, getPropArrayInt, setPropArrayInt,
+        getPropArrayFloat, setPropArrayFloat, getPropsDouble };
 
 
 SaslPropsCallbacks* xap::getPropsCallbacks()